@@ -1003,6 +1003,8 @@ static int intel_context_set_gem(struct intel_context *ce,
 	if (test_bit(UCONTEXT_LOW_LATENCY, &ctx->user_flags))
 		__set_bit(CONTEXT_LOW_LATENCY, &ce->flags);
 
+	intel_context_set_freq_hint(ce, ctx->sched.priority);
+
 	return ret;
 }
 
@@ -2081,6 +2083,8 @@ static int set_priority(struct i915_gem_context *ctx,
 	ctx->sched.priority = args->value;
 
 	for_each_gem_engine(ce, i915_gem_context_lock_engines(ctx), it) {
+		intel_context_set_freq_hint(ce, ctx->sched.priority);
+
 		if (!intel_engine_has_timeslices(ce->engine))
 			continue;
 
@@ -217,6 +217,7 @@ struct dma_buf *i915_gem_prime_export(struct drm_gem_object *gem_obj, int flags)
 {
 	struct drm_i915_gem_object *obj = to_intel_bo(gem_obj);
 	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct dma_buf *dmabuf;
 
 	exp_info.ops = &i915_dmabuf_ops;
 	exp_info.size = gem_obj->size;
@@ -230,7 +231,11 @@ struct dma_buf *i915_gem_prime_export(struct drm_gem_object *gem_obj, int flags)
 			return ERR_PTR(ret);
 	}
 
-	return drm_gem_dmabuf_export(gem_obj->dev, &exp_info);
+	dmabuf = drm_gem_dmabuf_export(gem_obj->dev, &exp_info);
+	if (!IS_ERR(dmabuf))
+		i915_drm_client_export_object(obj);
+
+	return dmabuf;
 }
 
 static int i915_gem_object_get_pages_dmabuf(struct drm_i915_gem_object *obj)
@@ -111,6 +111,7 @@ void i915_gem_object_init(struct drm_i915_gem_object *obj,
 #ifdef CONFIG_PROC_FS
 	INIT_LIST_HEAD(&obj->client_link);
 #endif
+	i915_drm_client_init_object(obj);
 
 	INIT_LIST_HEAD(&obj->lut_list);
 	spin_lock_init(&obj->lut_lock);
@@ -236,6 +237,13 @@ bool i915_gem_object_can_bypass_llc(struct drm_i915_gem_object *obj)
 	return (IS_JASPERLAKE(i915) || IS_ELKHARTLAKE(i915));
 }
 
+static int i915_gem_open_object(struct drm_gem_object *gem, struct drm_file *file)
+{
+	struct drm_i915_file_private *fpriv = file->driver_priv;
+
+	return i915_drm_client_open_object(fpriv->client, to_intel_bo(gem));
+}
+
 static void i915_gem_close_object(struct drm_gem_object *gem, struct drm_file *file)
 {
 	struct drm_i915_gem_object *obj = to_intel_bo(gem);
@@ -245,6 +253,8 @@ static void i915_gem_close_object(struct drm_gem_object *gem, struct drm_file *f
 	struct i915_lut_handle *lut, *ln;
 	LIST_HEAD(close);
 
+	i915_drm_client_close_object(fpriv->client, obj);
+
 	spin_lock(&obj->lut_lock);
 	list_for_each_entry_safe(lut, ln, &obj->lut_list, obj_link) {
 		struct i915_gem_context *ctx = lut->ctx;
@@ -920,6 +930,7 @@ int __init i915_objects_module_init(void)
 
 static const struct drm_gem_object_funcs i915_gem_object_funcs = {
 	.free = i915_gem_free_object,
+	.open = i915_gem_open_object,
 	.close = i915_gem_close_object,
 	.export = i915_gem_prime_export,
 	.vmap = i915_gem_vmap_object,
@@ -788,6 +788,9 @@ i915_gem_object_pin_to_display_plane(struct drm_i915_gem_object *obj,
 				     const struct i915_gtt_view *view,
 				     unsigned int flags);
 
+struct list_head *i915_gem_object_shrink_list(struct drm_i915_gem_object *obj);
+void __i915_gem_object_shrink_list_add(struct drm_i915_gem_object *obj,
+				       bool purgeable);
 void i915_gem_object_make_unshrinkable(struct drm_i915_gem_object *obj);
 void i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj);
 void __i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj);
@@ -19,6 +19,7 @@
 #include "gt/intel_gt_defines.h"
 
 struct drm_i915_gem_object;
+struct i915_drm_client;
 struct intel_fronbuffer;
 struct intel_memory_region;
 
@@ -34,6 +35,19 @@ struct i915_lut_handle {
 	u32 handle;
 };
 
+/*
+ * struct i915_drm_client_link accounts an object in the fdinfo memory
+ * statistics of a client, one for each handle a client holds to the object
+ * plus one embedded in the object for the client that created it internally.
+ */
+struct i915_drm_client_link {
+	struct drm_i915_gem_object *obj;
+	struct i915_drm_client *client;
+	struct list_head obj_link;
+	struct list_head active_link;
+	unsigned int active_region;
+};
+
 struct drm_i915_gem_object_ops {
 	unsigned int flags;
 #define I915_GEM_OBJECT_IS_SHRINKABLE			BIT(1)
@@ -311,6 +325,33 @@ struct drm_i915_gem_object {
 	 * @client_link: Link into @i915_drm_client.objects_list
 	 */
 	struct list_head client_link;
+
+	/**
+	 * @client_stats: How the object is currently accounted in the memory
+	 * statistics of the clients linked to it.
+	 */
+	struct {
+		/**
+		 * @client_stats.lock: protects @client_stats.links and the
+		 * accounted state
+		 */
+		spinlock_t lock;
+
+		/**
+		 * @client_stats.links: list of i915_drm_client_link, one per
+		 * client handle and for @client
+		 */
+		struct list_head links;
+
+		/** @client_stats.owner: link for @client */
+		struct i915_drm_client_link owner;
+
+		/** @client_stats.region: region the object is accounted in */
+		unsigned int region;
+
+		/** @client_stats.state: I915_DRM_CLIENT_OBJ_* accounted */
+		unsigned int state;
+	} client_stats;
 #endif
 
 	union {
@@ -674,11 +715,18 @@ struct drm_i915_gem_object {
 		struct i915_gem_object_page_iter get_dma_page;
 
 		/**
-		 * Element within i915->mm.shrink_list or i915->mm.purge_list,
-		 * locked by i915->mm.obj_lock.
+		 * Element within the shrink_list or purge_list of
+		 * i915->mm.shrink_nodes[shrink_nid], locked by
+		 * i915->mm.obj_lock.
 		 */
 		struct list_head link;
 
+		/**
+		 * NUMA node of the backing store, selecting the per node
+		 * shrink lists holding @link. Locked by i915->mm.obj_lock.
+		 */
+		int shrink_nid;
+
 		/**
 		 * Advice: are the backing pages purgeable?
 		 */
@@ -79,24 +79,19 @@ void __i915_gem_object_set_pages(struct drm_i915_gem_object *obj,
 	}
 
 	if (shrinkable && !i915_gem_object_has_self_managed_shrink_list(obj)) {
-		struct list_head *list;
 		unsigned long flags;
 
 		assert_object_held(obj);
 		spin_lock_irqsave(&i915->mm.obj_lock, flags);
 
-		i915->mm.shrink_count++;
-		i915->mm.shrink_memory += obj->base.size;
-
-		if (obj->mm.madv != I915_MADV_WILLNEED)
-			list = &i915->mm.purge_list;
-		else
-			list = &i915->mm.shrink_list;
-		list_add_tail(&obj->mm.link, list);
+		__i915_gem_object_shrink_list_add(obj,
+						  obj->mm.madv != I915_MADV_WILLNEED);
 
 		atomic_set(&obj->mm.shrink_pin, 0);
 		spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 	}
+
+	i915_drm_client_update_object(obj);
 }
 
 int ____i915_gem_object_get_pages(struct drm_i915_gem_object *obj)
@@ -221,6 +216,8 @@ __i915_gem_object_unset_pages(struct drm_i915_gem_object *obj)
 	if (IS_ERR_OR_NULL(pages))
 		return pages;
 
+	i915_drm_client_update_object(obj);
+
 	if (i915_gem_object_is_volatile(obj))
 		obj->mm.madv = I915_MADV_WILLNEED;
 
@@ -138,15 +138,11 @@ out_recover:
 void i915_gem_suspend_late(struct drm_i915_private *i915)
 {
 	struct drm_i915_gem_object *obj;
-	struct list_head *phases[] = {
-		&i915->mm.shrink_list,
-		&i915->mm.purge_list,
-		NULL
-	}, **phase;
 	struct intel_gt *gt;
 	unsigned long flags;
 	unsigned int i;
 	bool flush = false;
+	int nid;
 
 	/*
 	 * Neither the BIOS, ourselves or any other kernel
@@ -175,11 +171,20 @@ void i915_gem_suspend_late(struct drm_i915_private *i915)
 		intel_gt_suspend_late(gt);
 
 	spin_lock_irqsave(&i915->mm.obj_lock, flags);
-	for (phase = phases; *phase; phase++) {
-		list_for_each_entry(obj, *phase, mm.link) {
-			if (!(obj->cache_coherent & I915_BO_CACHE_COHERENT_FOR_READ))
-				flush |= (obj->read_domains & I915_GEM_DOMAIN_CPU) == 0;
-			__start_cpu_write(obj); /* presume auto-hibernate */
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		struct i915_gem_shrink_node *node = &i915->mm.shrink_nodes[nid];
+		struct list_head *phases[] = {
+			&node->shrink_list,
+			&node->purge_list,
+			NULL
+		}, **phase;
+
+		for (phase = phases; *phase; phase++) {
+			list_for_each_entry(obj, *phase, mm.link) {
+				if (!(obj->cache_coherent & I915_BO_CACHE_COHERENT_FOR_READ))
+					flush |= (obj->read_domains & I915_GEM_DOMAIN_CPU) == 0;
+				__start_cpu_write(obj); /* presume auto-hibernate */
+			}
 		}
 	}
 	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
@@ -201,6 +206,7 @@ int i915_gem_freeze_late(struct drm_i915_private *i915)
 {
 	struct drm_i915_gem_object *obj;
 	intel_wakeref_t wakeref;
+	int nid;
 
 	/*
 	 * Called just before we write the hibernation image.
@@ -222,16 +228,21 @@ int i915_gem_freeze_late(struct drm_i915_private *i915)
 	i915_gem_drain_freed_objects(i915);
 
 	wbinvd_on_all_cpus();
-	list_for_each_entry(obj, &i915->mm.shrink_list, mm.link)
-		__start_cpu_write(obj);
+	for (nid = 0; nid < nr_node_ids; nid++)
+		list_for_each_entry(obj,
+				    &i915->mm.shrink_nodes[nid].shrink_list,
+				    mm.link)
+			__start_cpu_write(obj);
 
 	return 0;
 }
 
 void i915_gem_resume(struct drm_i915_private *i915)
 {
+	int err[I915_MAX_GT] = {};
 	struct intel_gt *gt;
-	int ret, i, j;
+	bool failed = false;
+	int ret, i;
 
 	GEM_TRACE("%s\n", dev_name(i915->drm.dev));
 
@@ -242,10 +253,18 @@ void i915_gem_resume(struct drm_i915_private *i915)
 	 * As we didn't flush the kernel context before suspend, we cannot
 	 * guarantee that the context image is complete. So let's just reset
 	 * it and start again.
+	 *
+	 * The GTs are resumed one after another, as they share the GGTT,
+	 * the uncore and the SR-IOV state being restored. A GT that fails
+	 * does not prevent us from resuming the others.
 	 */
-	for_each_gt(gt, i915, i)
-		if (intel_gt_resume(gt))
-			goto err_wedged;
+	for_each_gt(gt, i915, i) {
+		err[i] = intel_gt_resume(gt);
+		if (err[i])
+			failed = true;
+	}
+	if (failed)
+		goto err_wedged;
 
 	ret = lmem_restore(i915, I915_TTM_BACKUP_ALLOW_GPU);
 	GEM_WARN_ON(ret);
@@ -255,15 +274,12 @@ void i915_gem_resume(struct drm_i915_private *i915)
 	return;
 
 err_wedged:
-	for_each_gt(gt, i915, j) {
-		if (!intel_gt_is_wedged(gt)) {
+	for_each_gt(gt, i915, i) {
+		if (err[i] && !intel_gt_is_wedged(gt)) {
 			dev_err(i915->drm.dev,
 				"Failed to re-initialize GPU[%u], declaring it wedged!\n",
-				j);
+				i);
 			intel_gt_set_wedged(gt);
 		}
-
-		if (j == i)
-			break;
 	}
 }
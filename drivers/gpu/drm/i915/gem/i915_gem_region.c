@@ -18,6 +18,9 @@ void i915_gem_object_init_memory_region(struct drm_i915_gem_object *obj,
 	mutex_lock(&mem->objects.lock);
 	list_add(&obj->mm.region_link, &mem->objects.list);
 	mutex_unlock(&mem->objects.lock);
+
+	/* Account a migrated object against its new region */
+	i915_drm_client_update_object(obj);
 }
 
 void i915_gem_object_release_memory_region(struct drm_i915_gem_object *obj)
@@ -73,6 +73,7 @@ int shmem_sg_alloc_table(struct drm_i915_private *i915, struct sg_table *st,
 	unsigned int page_count; /* restricted by sg_alloc_table */
 	unsigned long i;
 	struct scatterlist *sg;
+	struct folio *last = NULL;
 	unsigned long next_pfn = 0;	/* suppress gcc warning */
 	gfp_t noreclaim;
 	int ret;
@@ -105,7 +106,7 @@ int shmem_sg_alloc_table(struct drm_i915_private *i915, struct sg_table *st,
 	st->nents = 0;
 	for (i = 0; i < page_count; i++) {
 		struct folio *folio;
-		unsigned long nr_pages;
+		unsigned long nr_pages, pgoff, pfn;
 		const unsigned int shrink[] = {
 			I915_SHRINK_BOUND | I915_SHRINK_UNBOUND,
 			0,
@@ -156,27 +157,40 @@ int shmem_sg_alloc_table(struct drm_i915_private *i915, struct sg_table *st,
 			}
 		} while (1);
 
+		/*
+		 * A segment may end part way through a large folio, in which
+		 * case we come back for the remainder of the same folio. We
+		 * already hold a reference to it from the first lookup, and
+		 * shmem_sg_free_table() only drops one per folio.
+		 */
+		if (folio == last)
+			folio_put(folio);
+		last = folio;
+
+		pgoff = i - folio->index;
+		pfn = folio_pfn(folio) + pgoff;
 		nr_pages = min_array(((unsigned long[]) {
-					folio_nr_pages(folio),
+					folio_nr_pages(folio) - pgoff,
 					page_count - i,
 					max_segment / PAGE_SIZE,
 				      }), 3);
 
 		if (!i ||
 		    sg->length >= max_segment ||
-		    folio_pfn(folio) != next_pfn) {
+		    pfn != next_pfn) {
 			if (i)
 				sg = sg_next(sg);
 
 			st->nents++;
-			sg_set_folio(sg, folio, nr_pages * PAGE_SIZE, 0);
+			sg_set_page(sg, folio_page(folio, pgoff),
+				    nr_pages * PAGE_SIZE, 0);
 		} else {
 			nr_pages = min_t(unsigned long, nr_pages,
 					 (max_segment - sg->length) / PAGE_SIZE);
 
 			sg->length += nr_pages * PAGE_SIZE;
 		}
-		next_pfn = folio_pfn(folio) + nr_pages;
+		next_pfn = pfn + nr_pages;
 		i += nr_pages - 1;
 
 		/* Check that the i965g/gm workaround works. */
@@ -218,7 +232,8 @@ static int shmem_get_pages(struct drm_i915_gem_object *obj)
 	struct drm_i915_private *i915 = to_i915(obj->base.dev);
 	struct intel_memory_region *mem = obj->mm.region;
 	struct address_space *mapping = obj->base.filp->f_mapping;
-	unsigned int max_segment = i915_sg_segment_size(i915->drm.dev);
+	unsigned int max_segment =
+		i915_sg_segment_align(i915_sg_segment_size(i915->drm.dev));
 	struct sg_table *st;
 	int ret;
 
@@ -245,13 +260,15 @@ rebuild_st:
 		/*
 		 * DMA remapping failed? One possible cause is that
 		 * it could not reserve enough large entries, asking
-		 * for PAGE_SIZE chunks instead may be helpful.
+		 * for smaller chunks instead may be helpful. Step down
+		 * through the GTT page sizes so that we keep using huge
+		 * PTEs for as long as possible.
 		 */
 		if (max_segment > PAGE_SIZE) {
 			shmem_sg_free_table(st, mapping, false, false);
 			kfree(st);
 
-			max_segment = PAGE_SIZE;
+			max_segment = i915_sg_segment_fallback(max_segment);
 			goto rebuild_st;
 		} else {
 			dev_warn(i915->drm.dev,
@@ -74,50 +74,100 @@ static int try_to_writeback(struct drm_i915_gem_object *obj, unsigned int flags)
 	return 0;
 }
 
-/**
- * i915_gem_shrink - Shrink buffer object caches
- * @ww: i915 gem ww acquire ctx, or NULL
- * @i915: i915 device
- * @target: amount of memory to make available, in pages
- * @nr_scanned: optional output for number of pages scanned (incremental)
- * @shrink: control flags for selecting cache types
- *
- * This function is the main interface to the shrinker. It will try to release
- * up to @target pages of main memory backing storage from buffer objects.
- * Selection of the specific caches can be done with @flags. This is e.g. useful
- * when purgeable objects should be removed from caches preferentially.
- *
- * Note that it's not guaranteed that released amount is actually available as
- * free system memory - the pages might still be in-used to due to other reasons
- * (like cpu mmaps) or the mm core has reused them before we could grab them.
- * Therefore code that needs to explicitly shrink buffer objects caches (e.g. to
- * avoid deadlocks in memory reclaim) must fall back to i915_gem_shrink_all().
- *
- * Also note that any kind of pinning (both per-vma address space pins and
- * backing storage pins at the buffer object level) result in the shrinker code
- * having to skip the object.
- *
- * Returns:
- * The number of pages of backing storage actually released.
- */
-unsigned long
-i915_gem_shrink(struct i915_gem_ww_ctx *ww,
-		struct drm_i915_private *i915,
-		unsigned long target,
-		unsigned long *nr_scanned,
-		unsigned int shrink)
+static int shrink_list(struct i915_gem_ww_ctx *ww,
+		       struct drm_i915_private *i915,
+		       struct list_head *list,
+		       unsigned long target,
+		       unsigned long *count,
+		       unsigned long *scanned,
+		       unsigned int shrink,
+		       bool trylock_vm)
+{
+	struct drm_i915_gem_object *obj;
+	LIST_HEAD(still_in_list);
+	unsigned long flags;
+	int err = 0;
+
+	/*
+	 * We serialize our access to unreferenced objects through
+	 * the use of the obj_lock. While the objects are not
+	 * yet freed (due to RCU then a workqueue) we still want
+	 * to be able to shrink their pages, so they remain on
+	 * the unbound/bound list until actually freed.
+	 */
+	spin_lock_irqsave(&i915->mm.obj_lock, flags);
+	while (*count < target &&
+	       (obj = list_first_entry_or_null(list,
+					       typeof(*obj),
+					       mm.link))) {
+		list_move_tail(&obj->mm.link, &still_in_list);
+
+		if (shrink & I915_SHRINK_VMAPS &&
+		    !is_vmalloc_addr(obj->mm.mapping))
+			continue;
+
+		if (!(shrink & I915_SHRINK_ACTIVE) &&
+		    i915_gem_object_is_framebuffer(obj))
+			continue;
+
+		if (!can_release_pages(obj))
+			continue;
+
+		if (!kref_get_unless_zero(&obj->base.refcount))
+			continue;
+
+		spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
+
+		/* May arrive from get_pages on another bo */
+		if (!ww) {
+			if (!i915_gem_object_trylock(obj, NULL))
+				goto skip;
+		} else {
+			err = i915_gem_object_lock(obj, ww);
+			if (err)
+				goto skip;
+		}
+
+		if (drop_pages(obj, shrink, trylock_vm) &&
+		    !__i915_gem_object_put_pages(obj) &&
+		    !try_to_writeback(obj, shrink))
+			*count += obj->base.size >> PAGE_SHIFT;
+
+		if (!ww)
+			i915_gem_object_unlock(obj);
+
+		*scanned += obj->base.size >> PAGE_SHIFT;
+skip:
+		i915_gem_object_put(obj);
+
+		spin_lock_irqsave(&i915->mm.obj_lock, flags);
+		if (err)
+			break;
+	}
+	list_splice_tail(&still_in_list, list);
+	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
+
+	return err;
+}
+
+static unsigned long
+__i915_gem_shrink(struct i915_gem_ww_ctx *ww,
+		  struct drm_i915_private *i915,
+		  int nid,
+		  unsigned long target,
+		  unsigned long *nr_scanned,
+		  unsigned int shrink)
 {
 	const struct {
-		struct list_head *list;
+		bool purge;
 		unsigned int bit;
 	} phases[] = {
-		{ &i915->mm.purge_list, ~0u },
-		{
-			&i915->mm.shrink_list,
-			I915_SHRINK_BOUND | I915_SHRINK_UNBOUND
-		},
-		{ NULL, 0 },
+		{ true, ~0u },
+		{ false, I915_SHRINK_BOUND | I915_SHRINK_UNBOUND },
+		{ false, 0 },
 	}, *phase;
+	int first = nid == NUMA_NO_NODE ? 0 : nid;
+	int last = nid == NUMA_NO_NODE ? nr_node_ids - 1 : nid;
 	intel_wakeref_t wakeref = NULL;
 	unsigned long count = 0;
 	unsigned long scanned = 0;
@@ -175,74 +225,23 @@ i915_gem_shrink(struct i915_gem_ww_ctx *ww,
 	 * i915->mm.obj_lock and so we won't ever be able to observe an
 	 * object on the bound_list with a reference count equals 0.
 	 */
-	for (phase = phases; phase->list; phase++) {
-		struct list_head still_in_list;
-		struct drm_i915_gem_object *obj;
-		unsigned long flags;
-
+	for (phase = phases; phase->bit; phase++) {
 		if ((shrink & phase->bit) == 0)
 			continue;
 
-		INIT_LIST_HEAD(&still_in_list);
-
-		/*
-		 * We serialize our access to unreferenced objects through
-		 * the use of the obj_lock. While the objects are not
-		 * yet freed (due to RCU then a workqueue) we still want
-		 * to be able to shrink their pages, so they remain on
-		 * the unbound/bound list until actually freed.
-		 */
-		spin_lock_irqsave(&i915->mm.obj_lock, flags);
-		while (count < target &&
-		       (obj = list_first_entry_or_null(phase->list,
-						       typeof(*obj),
-						       mm.link))) {
-			list_move_tail(&obj->mm.link, &still_in_list);
-
-			if (shrink & I915_SHRINK_VMAPS &&
-			    !is_vmalloc_addr(obj->mm.mapping))
-				continue;
-
-			if (!(shrink & I915_SHRINK_ACTIVE) &&
-			    i915_gem_object_is_framebuffer(obj))
-				continue;
+		for (i = first; i <= last && count < target; i++) {
+			struct i915_gem_shrink_node *node =
+				&i915->mm.shrink_nodes[i];
 
-			if (!can_release_pages(obj))
-				continue;
-
-			if (!kref_get_unless_zero(&obj->base.refcount))
-				continue;
-
-			spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
-
-			/* May arrive from get_pages on another bo */
-			if (!ww) {
-				if (!i915_gem_object_trylock(obj, NULL))
-					goto skip;
-			} else {
-				err = i915_gem_object_lock(obj, ww);
-				if (err)
-					goto skip;
-			}
-
-			if (drop_pages(obj, shrink, trylock_vm) &&
-			    !__i915_gem_object_put_pages(obj) &&
-			    !try_to_writeback(obj, shrink))
-				count += obj->base.size >> PAGE_SHIFT;
-
-			if (!ww)
-				i915_gem_object_unlock(obj);
-
-			scanned += obj->base.size >> PAGE_SHIFT;
-skip:
-			i915_gem_object_put(obj);
-
-			spin_lock_irqsave(&i915->mm.obj_lock, flags);
+			err = shrink_list(ww, i915,
+					  phase->purge ?
+					  &node->purge_list :
+					  &node->shrink_list,
+					  target, &count, &scanned,
+					  shrink, trylock_vm);
 			if (err)
 				break;
 		}
-		list_splice_tail(&still_in_list, phase->list);
-		spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 		if (err)
 			break;
 	}
@@ -250,6 +249,8 @@ skip:
 	if (shrink & I915_SHRINK_BOUND)
 		intel_runtime_pm_put(&i915->runtime_pm, wakeref);
 
+	trace_i915_gem_shrink_done(i915, nid, target, scanned, count);
+
 	if (err)
 		return err;
 
@@ -258,6 +259,43 @@ skip:
 	return count;
 }
 
+/**
+ * i915_gem_shrink - Shrink buffer object caches
+ * @ww: i915 gem ww acquire ctx, or NULL
+ * @i915: i915 device
+ * @target: amount of memory to make available, in pages
+ * @nr_scanned: optional output for number of pages scanned (incremental)
+ * @shrink: control flags for selecting cache types
+ *
+ * This function is the main interface to the shrinker. It will try to release
+ * up to @target pages of main memory backing storage from buffer objects.
+ * Selection of the specific caches can be done with @flags. This is e.g. useful
+ * when purgeable objects should be removed from caches preferentially.
+ *
+ * Note that it's not guaranteed that released amount is actually available as
+ * free system memory - the pages might still be in-used to due to other reasons
+ * (like cpu mmaps) or the mm core has reused them before we could grab them.
+ * Therefore code that needs to explicitly shrink buffer objects caches (e.g. to
+ * avoid deadlocks in memory reclaim) must fall back to i915_gem_shrink_all().
+ *
+ * Also note that any kind of pinning (both per-vma address space pins and
+ * backing storage pins at the buffer object level) result in the shrinker code
+ * having to skip the object.
+ *
+ * Returns:
+ * The number of pages of backing storage actually released.
+ */
+unsigned long
+i915_gem_shrink(struct i915_gem_ww_ctx *ww,
+		struct drm_i915_private *i915,
+		unsigned long target,
+		unsigned long *nr_scanned,
+		unsigned int shrink)
+{
+	return __i915_gem_shrink(ww, i915, NUMA_NO_NODE,
+				 target, nr_scanned, shrink);
+}
+
 /**
  * i915_gem_shrink_all - Shrink buffer object caches completely
  * @i915: i915 device
@@ -311,7 +349,7 @@ i915_gem_shrinker_count(struct shrinker *shrinker, struct shrink_control *sc)
 			    128ul /* default SHRINK_BATCH */);
 	}
 
-	return count;
+	return READ_ONCE(i915->mm.shrink_nodes[sc->nid].shrink_pages);
 }
 
 static unsigned long
@@ -322,22 +360,25 @@ i915_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 
 	sc->nr_scanned = 0;
 
-	freed = i915_gem_shrink(NULL, i915,
-				sc->nr_to_scan,
-				&sc->nr_scanned,
-				I915_SHRINK_BOUND |
-				I915_SHRINK_UNBOUND);
+	/* Hand any recycled requests back to the slab for reclaim */
+	i915_request_magazines_drain();
+
+	freed = __i915_gem_shrink(NULL, i915, sc->nid,
+				  sc->nr_to_scan,
+				  &sc->nr_scanned,
+				  I915_SHRINK_BOUND |
+				  I915_SHRINK_UNBOUND);
 	if (sc->nr_scanned < sc->nr_to_scan && current_is_kswapd()) {
 		intel_wakeref_t wakeref;
 
 		with_intel_runtime_pm(&i915->runtime_pm, wakeref) {
-			freed += i915_gem_shrink(NULL, i915,
-						 sc->nr_to_scan - sc->nr_scanned,
-						 &sc->nr_scanned,
-						 I915_SHRINK_ACTIVE |
-						 I915_SHRINK_BOUND |
-						 I915_SHRINK_UNBOUND |
-						 I915_SHRINK_WRITEBACK);
+			freed += __i915_gem_shrink(NULL, i915, sc->nid,
+						   sc->nr_to_scan - sc->nr_scanned,
+						   &sc->nr_scanned,
+						   I915_SHRINK_ACTIVE |
+						   I915_SHRINK_BOUND |
+						   I915_SHRINK_UNBOUND |
+						   I915_SHRINK_WRITEBACK);
 		}
 	}
 
@@ -353,6 +394,7 @@ i915_gem_shrinker_oom(struct notifier_block *nb, unsigned long event, void *ptr)
 	unsigned long unevictable, available, freed_pages;
 	intel_wakeref_t wakeref;
 	unsigned long flags;
+	int nid;
 
 	freed_pages = 0;
 	with_intel_runtime_pm(&i915->runtime_pm, wakeref)
@@ -367,11 +409,15 @@ i915_gem_shrinker_oom(struct notifier_block *nb, unsigned long event, void *ptr)
 	 */
 	available = unevictable = 0;
 	spin_lock_irqsave(&i915->mm.obj_lock, flags);
-	list_for_each_entry(obj, &i915->mm.shrink_list, mm.link) {
-		if (!can_release_pages(obj))
-			unevictable += obj->base.size >> PAGE_SHIFT;
-		else
-			available += obj->base.size >> PAGE_SHIFT;
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		list_for_each_entry(obj,
+				    &i915->mm.shrink_nodes[nid].shrink_list,
+				    mm.link) {
+			if (!can_release_pages(obj))
+				unevictable += obj->base.size >> PAGE_SHIFT;
+			else
+				available += obj->base.size >> PAGE_SHIFT;
+		}
 	}
 	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 
@@ -429,7 +475,7 @@ i915_gem_shrinker_vmap(struct notifier_block *nb, unsigned long event, void *ptr
 
 void i915_gem_driver_register__shrinker(struct drm_i915_private *i915)
 {
-	i915->mm.shrinker = shrinker_alloc(0, "drm-i915_gem");
+	i915->mm.shrinker = shrinker_alloc(SHRINKER_NUMA_AWARE, "drm-i915_gem");
 	if (!i915->mm.shrinker) {
 		drm_WARN_ON(&i915->drm, 1);
 	} else {
@@ -472,6 +518,89 @@ void i915_gem_shrinker_taints_mutex(struct drm_i915_private *i915,
 	fs_reclaim_release(GFP_KERNEL);
 }
 
+static int i915_gem_object_shrink_nid(struct drm_i915_gem_object *obj)
+{
+	struct sg_table *pages = obj->mm.pages;
+	struct page *page;
+
+	if (nr_node_ids == 1)
+		return 0;
+
+	/*
+	 * Account the object to the node backing its first page; objects
+	 * with self-managed backing store (or none yet) are charged to the
+	 * local node of the caller, which is where they will be allocated.
+	 */
+	if (IS_ERR_OR_NULL(pages) || !i915_gem_object_has_struct_page(obj))
+		return numa_mem_id();
+
+	page = sg_page(pages->sgl);
+	return page ? page_to_nid(page) : numa_mem_id();
+}
+
+/**
+ * i915_gem_object_shrink_list - The shrink list matching the object state
+ * @obj: The GEM object.
+ *
+ * Return the purge or shrink list of the NUMA node the object is currently
+ * accounted to, depending on its madvise state. Must be called with
+ * i915->mm.obj_lock held.
+ */
+struct list_head *i915_gem_object_shrink_list(struct drm_i915_gem_object *obj)
+{
+	struct i915_gem_shrink_node *node =
+		&obj_to_i915(obj)->mm.shrink_nodes[obj->mm.shrink_nid];
+
+	lockdep_assert_held(&obj_to_i915(obj)->mm.obj_lock);
+
+	if (obj->mm.madv != I915_MADV_WILLNEED)
+		return &node->purge_list;
+	else
+		return &node->shrink_list;
+}
+
+/**
+ * __i915_gem_object_shrink_list_add - Make the object visible to the shrinker
+ * @obj: The GEM object.
+ * @purgeable: Whether to add the object to the purge list.
+ *
+ * Add the object to the tail of the purge or shrink list of the NUMA node
+ * backing it, and account it. Must be called with i915->mm.obj_lock held.
+ */
+void __i915_gem_object_shrink_list_add(struct drm_i915_gem_object *obj,
+				       bool purgeable)
+{
+	struct drm_i915_private *i915 = obj_to_i915(obj);
+	struct i915_gem_shrink_node *node;
+
+	lockdep_assert_held(&i915->mm.obj_lock);
+	GEM_BUG_ON(!list_empty(&obj->mm.link));
+
+	obj->mm.shrink_nid = i915_gem_object_shrink_nid(obj);
+	node = &i915->mm.shrink_nodes[obj->mm.shrink_nid];
+
+	list_add_tail(&obj->mm.link,
+		      purgeable ? &node->purge_list : &node->shrink_list);
+	node->shrink_pages += obj->base.size >> PAGE_SHIFT;
+
+	i915->mm.shrink_count++;
+	i915->mm.shrink_memory += obj->base.size;
+}
+
+static void __i915_gem_object_shrink_list_del(struct drm_i915_gem_object *obj)
+{
+	struct drm_i915_private *i915 = obj_to_i915(obj);
+
+	lockdep_assert_held(&i915->mm.obj_lock);
+
+	list_del_init(&obj->mm.link);
+	i915->mm.shrink_nodes[obj->mm.shrink_nid].shrink_pages -=
+		obj->base.size >> PAGE_SHIFT;
+
+	i915->mm.shrink_count--;
+	i915->mm.shrink_memory -= obj->base.size;
+}
+
 /**
  * i915_gem_object_make_unshrinkable - Hide the object from the shrinker. By
  * default all object types that support shrinking(see IS_SHRINKABLE), will also
@@ -498,16 +627,13 @@ void i915_gem_object_make_unshrinkable(struct drm_i915_gem_object *obj)
 
 	spin_lock_irqsave(&i915->mm.obj_lock, flags);
 	if (!atomic_fetch_inc(&obj->mm.shrink_pin) &&
-	    !list_empty(&obj->mm.link)) {
-		list_del_init(&obj->mm.link);
-		i915->mm.shrink_count--;
-		i915->mm.shrink_memory -= obj->base.size;
-	}
+	    !list_empty(&obj->mm.link))
+		__i915_gem_object_shrink_list_del(obj);
 	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 }
 
 static void ___i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj,
-					       struct list_head *head)
+					       bool purgeable)
 {
 	struct drm_i915_private *i915 = obj_to_i915(obj);
 	unsigned long flags;
@@ -520,14 +646,8 @@ static void ___i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj,
 
 	spin_lock_irqsave(&i915->mm.obj_lock, flags);
 	GEM_BUG_ON(!kref_read(&obj->base.refcount));
-	if (atomic_dec_and_test(&obj->mm.shrink_pin)) {
-		GEM_BUG_ON(!list_empty(&obj->mm.link));
-
-		list_add_tail(&obj->mm.link, head);
-		i915->mm.shrink_count++;
-		i915->mm.shrink_memory += obj->base.size;
-
-	}
+	if (atomic_dec_and_test(&obj->mm.shrink_pin))
+		__i915_gem_object_shrink_list_add(obj, purgeable);
 	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 }
 
@@ -543,8 +663,7 @@ static void ___i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj,
  */
 void __i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj)
 {
-	___i915_gem_object_make_shrinkable(obj,
-					   &obj_to_i915(obj)->mm.shrink_list);
+	___i915_gem_object_make_shrinkable(obj, false);
 }
 
 /**
@@ -559,8 +678,7 @@ void __i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj)
  */
 void __i915_gem_object_make_purgeable(struct drm_i915_gem_object *obj)
 {
-	___i915_gem_object_make_shrinkable(obj,
-					   &obj_to_i915(obj)->mm.purge_list);
+	___i915_gem_object_make_shrinkable(obj, true);
 }
 
 /**
@@ -99,7 +99,8 @@ static void i915_gem_object_userptr_drop_ref(struct drm_i915_gem_object *obj)
 
 static int i915_gem_userptr_get_pages(struct drm_i915_gem_object *obj)
 {
-	unsigned int max_segment = i915_sg_segment_size(obj->base.dev->dev);
+	unsigned int max_segment =
+		i915_sg_segment_align(i915_sg_segment_size(obj->base.dev->dev));
 	struct sg_table *st;
 	struct page **pvec;
 	unsigned int num_pages; /* limited by sg_alloc_table_from_pages_segment */
@@ -133,7 +134,7 @@ alloc_table:
 		sg_free_table(st);
 
 		if (max_segment > PAGE_SIZE) {
-			max_segment = PAGE_SIZE;
+			max_segment = i915_sg_segment_fallback(max_segment);
 			goto alloc_table;
 		}
 
@@ -211,18 +211,34 @@ static void signal_irq_work(struct irq_work *work)
 	rcu_read_lock();
 	atomic_inc(&b->signaler_active);
 	list_for_each_entry_rcu(ce, &b->signalers, signal_link) {
+		bool retire = true;
 		struct i915_request *rq;
 
 		list_for_each_entry_rcu(rq, &ce->signals, signal_link) {
 			bool release;
 
-			if (!__i915_request_is_complete(rq))
+			if (!__i915_request_is_complete(rq)) {
+				/* Note when the next request starts running */
+				if (__i915_request_has_started(rq))
+					i915_request_mark_context_in(rq);
 				break;
+			}
 
 			if (!test_and_clear_bit(I915_FENCE_FLAG_SIGNAL,
 						&rq->fence.flags))
 				break;
 
+			/*
+			 * Queue the timeline for retirement on this cpu as
+			 * soon as it has completed requests, rather than
+			 * wait for the periodic retire worker. We do so
+			 * before we may drop our reference to the context.
+			 */
+			if (retire) {
+				add_retire(b, ce->timeline);
+				retire = false;
+			}
+
 			/*
 			 * Queue for execution after dropping the signaling
 			 * spinlock as the callback chain may end up adding
@@ -232,11 +248,8 @@ static void signal_irq_work(struct irq_work *work)
 			list_del_rcu(&rq->signal_link);
 			release = remove_signaling_context(b, ce);
 			spin_unlock(&ce->signal_lock);
-			if (release) {
-				if (intel_timeline_is_last(ce->timeline, rq))
-					add_retire(b, ce->timeline);
+			if (release)
 				intel_context_put(ce);
-			}
 
 			if (__dma_fence_signal(&rq->fence))
 				/* We own signal_node now, xfer to local list */
@@ -13,7 +13,9 @@
 #include "intel_context.h"
 #include "intel_engine.h"
 #include "intel_engine_pm.h"
+#include "intel_gt.h"
 #include "intel_ring.h"
+#include "uc/intel_guc_slpc.h"
 
 static struct kmem_cache *slab_ce;
 
@@ -403,6 +405,7 @@ intel_context_init(struct intel_context *ce, struct intel_engine_cs *engine)
 	ce->ring_size = SZ_4K;
 
 	ewma_runtime_init(&ce->stats.runtime.avg);
+	ewma_rq_duration_init(&ce->stats.rq_duration);
 
 	ce->vm = i915_vm_get(engine->gt->vm);
 
@@ -479,6 +482,40 @@ void intel_context_exit_engine(struct intel_context *ce)
 	intel_engine_pm_put(ce->engine);
 }
 
+static enum slpc_hint_class context_hint_class(const struct intel_context *ce)
+{
+	if (test_bit(CONTEXT_FREQ_LATENCY, &ce->flags))
+		return SLPC_HINT_LATENCY;
+	else if (test_bit(CONTEXT_FREQ_THROUGHPUT, &ce->flags))
+		return SLPC_HINT_THROUGHPUT;
+	else
+		return SLPC_HINT_NONE;
+}
+
+void intel_context_hint_enter(struct intel_context *ce)
+{
+	struct intel_gt *gt = ce->engine->gt;
+
+	if (!intel_uc_uses_guc_slpc(&gt->uc))
+		return;
+
+	/*
+	 * The priority, and so the class, may change while we are active;
+	 * remember the class we counted so that exit releases that one.
+	 */
+	ce->freq_hint = context_hint_class(ce);
+	if (ce->freq_hint)
+		intel_guc_slpc_hint_get(&gt_to_guc(gt)->slpc, ce->freq_hint);
+}
+
+void intel_context_hint_exit(struct intel_context *ce)
+{
+	struct intel_gt *gt = ce->engine->gt;
+
+	intel_guc_slpc_hint_put(&gt_to_guc(gt)->slpc, ce->freq_hint);
+	ce->freq_hint = SLPC_HINT_NONE;
+}
+
 int intel_context_prepare_remote_request(struct intel_context *ce,
 					 struct i915_request *rq)
 {
@@ -601,7 +638,7 @@ u64 intel_context_get_total_runtime_ns(struct intel_context *ce)
 	if (ce->ops->update_stats)
 		ce->ops->update_stats(ce);
 
-	total = ce->stats.runtime.total;
+	total = ce->stats.runtime.total + READ_ONCE(ce->stats.runtime.live);
 	if (ce->ops->flags & COPS_RUNTIME_CYCLES)
 		total *= ce->engine->gt->clock_period_ns;
 
@@ -205,6 +205,12 @@ static inline void intel_context_unpin(struct intel_context *ce)
 void intel_context_enter_engine(struct intel_context *ce);
 void intel_context_exit_engine(struct intel_context *ce);
 
+#define INTEL_CONTEXT_FREQ_HINTS \
+	(BIT(CONTEXT_FREQ_LATENCY) | BIT(CONTEXT_FREQ_THROUGHPUT))
+
+void intel_context_hint_enter(struct intel_context *ce);
+void intel_context_hint_exit(struct intel_context *ce);
+
 static inline void intel_context_enter(struct intel_context *ce)
 {
 	lockdep_assert_held(&ce->timeline->mutex);
@@ -213,6 +219,8 @@ static inline void intel_context_enter(struct intel_context *ce)
 
 	ce->ops->enter(ce);
 	ce->wakeref = intel_gt_pm_get(ce->vm->gt);
+	if (unlikely(ce->flags & INTEL_CONTEXT_FREQ_HINTS))
+		intel_context_hint_enter(ce);
 }
 
 static inline void intel_context_mark_active(struct intel_context *ce)
@@ -229,6 +237,8 @@ static inline void intel_context_exit(struct intel_context *ce)
 	if (--ce->active_count)
 		return;
 
+	if (unlikely(ce->freq_hint))
+		intel_context_hint_exit(ce);
 	intel_gt_pm_put_async(ce->vm->gt, ce->wakeref);
 	ce->ops->exit(ce);
 }
@@ -315,6 +325,26 @@ static inline void intel_context_clear_use_semaphores(struct intel_context *ce)
 	clear_bit(CONTEXT_USE_SEMAPHORES, &ce->flags);
 }
 
+/*
+ * The SLPC workload class follows the context priority: contexts above the
+ * default priority are latency sensitive, those below it are background
+ * throughput work. A change takes effect the next time the context becomes
+ * active.
+ */
+static inline void intel_context_set_freq_hint(struct intel_context *ce,
+					       int prio)
+{
+	if (prio > I915_PRIORITY_NORMAL)
+		set_bit(CONTEXT_FREQ_LATENCY, &ce->flags);
+	else
+		clear_bit(CONTEXT_FREQ_LATENCY, &ce->flags);
+
+	if (prio < I915_PRIORITY_NORMAL)
+		set_bit(CONTEXT_FREQ_THROUGHPUT, &ce->flags);
+	else
+		clear_bit(CONTEXT_FREQ_THROUGHPUT, &ce->flags);
+}
+
 static inline bool intel_context_is_banned(const struct intel_context *ce)
 {
 	return test_bit(CONTEXT_BANNED, &ce->flags);
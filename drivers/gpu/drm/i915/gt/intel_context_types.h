@@ -22,6 +22,7 @@
 
 #define CONTEXT_REDZONE POISON_INUSE
 DECLARE_EWMA(runtime, 3, 8);
+DECLARE_EWMA(rq_duration, 4, 8);
 
 struct i915_gem_context;
 struct i915_gem_ww_ctx;
@@ -133,6 +134,8 @@ struct intel_context {
 #define CONTEXT_EXITING			13
 #define CONTEXT_LOW_LATENCY		14
 #define CONTEXT_OWN_STATE		15
+#define CONTEXT_FREQ_THROUGHPUT		16
+#define CONTEXT_FREQ_LATENCY		17
 
 	struct {
 		u64 timeout_us;
@@ -156,13 +159,27 @@ struct intel_context {
 		struct {
 			struct ewma_runtime avg;
 			u64 total;
+			/*
+			 * Cycles since the last context switch-in that are not
+			 * yet saved into the context image, sampled on demand
+			 * by backends that cannot observe the switch directly.
+			 */
+			u64 live;
 			u32 last;
 			I915_SELFTEST_DECLARE(u32 num_underflow);
 			I915_SELFTEST_DECLARE(u32 max_underflow);
 		} runtime;
+
+		/*
+		 * Time from submission to the HW until the breadcrumb is
+		 * signaled, in ns, averaged over recently retired requests.
+		 * Used to predict whether a waiter should busywait.
+		 */
+		struct ewma_rq_duration rq_duration;
 	} stats;
 
 	unsigned int active_count; /* protected by timeline->mutex */
+	unsigned int freq_hint; /* SLPC class counted while active, ditto */
 
 	atomic_t pin_count;
 	struct mutex pin_mutex; /* guards pinning and associated on-gpuing */
@@ -210,6 +227,13 @@ struct intel_context {
 		struct list_head requests;
 		/** @prio: the context's current guc priority */
 		u8 prio;
+		/** @prio_raised: jiffies when @prio was last raised */
+		unsigned long prio_raised;
+		/**
+		 * @prio_work: worker to lower @prio once the hold after
+		 * raising it has expired
+		 */
+		struct delayed_work prio_work;
 		/**
 		 * @prio_count: a counter of the number requests in flight in
 		 * each priority bucket
@@ -265,6 +265,11 @@ __printf(3, 4)
 void intel_engine_dump(struct intel_engine_cs *engine,
 		       struct drm_printer *m,
 		       const char *header, ...);
+void intel_engine_record_latency(struct intel_engine_cs *engine,
+				 enum intel_engine_latency stage,
+				 ktime_t dt);
+void intel_engine_dump_latency(struct intel_engine_cs *engine,
+			       struct drm_printer *m);
 void intel_engine_dump_active_requests(struct list_head *requests,
 				       struct i915_request *hung_rq,
 				       struct drm_printer *m);
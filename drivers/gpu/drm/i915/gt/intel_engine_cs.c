@@ -2430,6 +2430,50 @@ static void engine_dump_active_requests(struct intel_engine_cs *engine,
 		i915_request_put(hung_rq);
 }
 
+void intel_engine_record_latency(struct intel_engine_cs *engine,
+				 enum intel_engine_latency stage,
+				 ktime_t dt)
+{
+	u64 us = ktime_to_us(dt);
+	unsigned int bucket;
+
+	if (ktime_to_ns(dt) < 0)
+		return;
+
+	bucket = us ? min_t(unsigned int, ilog2(us) + 1,
+			    INTEL_ENGINE_LATENCY_BUCKETS - 1) : 0;
+	atomic_long_inc(&engine->stats.latency[stage][bucket]);
+}
+
+void intel_engine_dump_latency(struct intel_engine_cs *engine,
+			       struct drm_printer *m)
+{
+	static const char * const names[] = {
+		[INTEL_ENGINE_LATENCY_QUEUE] = "add to submit",
+		[INTEL_ENGINE_LATENCY_SCHEDULE] = "submit to context-in",
+		[INTEL_ENGINE_LATENCY_RUN] = "context-in to signal",
+	};
+	unsigned int stage, bucket;
+
+	BUILD_BUG_ON(ARRAY_SIZE(names) != INTEL_ENGINE_LATENCY_COUNT);
+
+	for (stage = 0; stage < INTEL_ENGINE_LATENCY_COUNT; stage++) {
+		drm_printf(m, "\t%s:\n", names[stage]);
+		for (bucket = 0; bucket < INTEL_ENGINE_LATENCY_BUCKETS; bucket++) {
+			long count =
+				atomic_long_read(&engine->stats.latency[stage][bucket]);
+
+			if (!count)
+				continue;
+
+			drm_printf(m, "\t\t%s%lluus: %ld\n",
+				   bucket ? ">=" : "<",
+				   bucket ? BIT_ULL(bucket - 1) : 1ull,
+				   count);
+		}
+	}
+}
+
 void intel_engine_dump(struct intel_engine_cs *engine,
 		       struct drm_printer *m,
 		       const char *header, ...)
@@ -2455,6 +2499,14 @@ void intel_engine_dump(struct intel_engine_cs *engine,
 		   str_yes_no(!llist_empty(&engine->barrier_tasks)));
 	drm_printf(m, "\tLatency: %luus\n",
 		   ewma__engine_latency_read(&engine->latency));
+	drm_printf(m, "\tBusywait: %ld hits, %ld misses, %ld skipped\n",
+		   atomic_long_read(&engine->stats.busywait.hit),
+		   atomic_long_read(&engine->stats.busywait.miss),
+		   atomic_long_read(&engine->stats.busywait.skip));
+	drm_printf(m, "\tDeadlines: %ld met, %ld missed, %ld boosted\n",
+		   atomic_long_read(&engine->stats.deadline.met),
+		   atomic_long_read(&engine->stats.deadline.miss),
+		   atomic_long_read(&engine->stats.deadline.boost));
 	if (intel_engine_supports_stats(engine))
 		drm_printf(m, "\tRuntime: %llums\n",
 			   ktime_to_ms(intel_engine_get_busy_time(engine,
@@ -296,6 +296,16 @@ struct intel_engine_execlists {
 
 #define INTEL_ENGINE_CS_MAX_NAME 8
 
+enum intel_engine_latency {
+	INTEL_ENGINE_LATENCY_QUEUE,	/* i915_request_add() to submission */
+	INTEL_ENGINE_LATENCY_SCHEDULE,	/* submission to context-in */
+	INTEL_ENGINE_LATENCY_RUN,	/* context-in to breadcrumb signal */
+	INTEL_ENGINE_LATENCY_COUNT
+};
+
+/* log2 buckets of microseconds, the last one being open ended */
+#define INTEL_ENGINE_LATENCY_BUCKETS 24
+
 struct intel_engine_execlists_stats {
 	/**
 	 * @active: Number of contexts currently scheduled in.
@@ -631,6 +641,35 @@ struct intel_engine_cs {
 		 * @rps: Utilisation at last RPS sampling.
 		 */
 		ktime_t rps;
+
+		/**
+		 * @busywait: Outcome of the adaptive busywait in
+		 * i915_request_wait(). @hit completed whilst spinning, @miss
+		 * spun and then had to sleep, @skip went straight to sleep as
+		 * the request was predicted to run for too long.
+		 */
+		struct {
+			atomic_long_t hit;
+			atomic_long_t miss;
+			atomic_long_t skip;
+		} busywait;
+
+		/**
+		 * @deadline: Requests with a dma_fence deadline, counted as
+		 * they retire by whether they signaled in time, and how many
+		 * were raised to display priority as the deadline approached.
+		 */
+		struct {
+			atomic_long_t met;
+			atomic_long_t miss;
+			atomic_long_t boost;
+		} deadline;
+
+		/**
+		 * @latency: Histograms of the time requests spend in each
+		 * stage of submission, see enum intel_engine_latency.
+		 */
+		atomic_long_t latency[INTEL_ENGINE_LATENCY_COUNT][INTEL_ENGINE_LATENCY_BUCKETS];
 	} stats;
 
 	struct {
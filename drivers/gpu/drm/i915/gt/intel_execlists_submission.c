@@ -1996,6 +1996,10 @@ process_csb(struct intel_engine_cs *engine, struct i915_request **inactive)
 		}
 	} while (head != tail);
 
+	/* Whatever is now at the head of the ELSP has been switched in */
+	if (*execlists->active)
+		i915_request_mark_context_in(*execlists->active);
+
 	/*
 	 * Gen11 has proven to fail wrt global observation point between
 	 * entry and tail update, failing on the ordering and thus
@@ -201,6 +201,7 @@ void intel_gt_info_print(const struct intel_gt_info *info,
 void intel_boost_fake_int_timer(struct intel_gt *gt, bool on_off);
 
 void intel_gt_watchdog_work(struct work_struct *work);
+void intel_gt_deadline_work(struct work_struct *work);
 
 enum i915_map_type intel_gt_coherent_map_type(struct intel_gt *gt,
 					      struct drm_i915_gem_object *obj,
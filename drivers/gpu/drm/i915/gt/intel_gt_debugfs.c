@@ -13,6 +13,7 @@
 #include "intel_gt_engines_debugfs.h"
 #include "intel_gt_mcr.h"
 #include "intel_gt_pm_debugfs.h"
+#include "intel_gt_requests.h"
 #include "intel_sseu_debugfs.h"
 #include "iov/intel_iov_debugfs.h"
 #include "uc/intel_uc_debugfs.h"
@@ -73,11 +74,23 @@ static int steering_show(struct seq_file *m, void *data)
 }
 DEFINE_INTEL_GT_DEBUGFS_ATTRIBUTE(steering);
 
+static int retire_show(struct seq_file *m, void *data)
+{
+	struct drm_printer p = drm_seq_file_printer(m);
+	struct intel_gt *gt = m->private;
+
+	intel_gt_show_retire(gt, &p);
+
+	return 0;
+}
+DEFINE_INTEL_GT_DEBUGFS_ATTRIBUTE(retire);
+
 static void gt_debugfs_register(struct intel_gt *gt, struct dentry *root)
 {
 	static const struct intel_gt_debugfs_file files[] = {
 		{ .name = "reset", .fops = &reset_fops },
 		{ .name = "steering", .fops = &steering_fops },
+		{ .name = "retire", .fops = &retire_fops },
 	};
 
 	intel_gt_debugfs_register_files(root, files, ARRAY_SIZE(files), gt);
@@ -112,6 +112,7 @@ static int __gt_park(struct intel_wakeref *wf)
 
 	runtime_end(gt);
 	intel_gt_park_requests(gt);
+	i915_request_magazines_drain();
 
 	intel_guc_busyness_park(gt);
 	i915_vma_parked(gt);
@@ -5,6 +5,10 @@
 
 #include <linux/workqueue.h>
 
+#include <drm/drm_print.h>
+
+#include "gem/i915_gem_object.h"
+
 #include "i915_drv.h" /* for_each_engine() */
 #include "i915_request.h"
 #include "intel_engine_heartbeat.h"
@@ -14,6 +18,13 @@
 #include "intel_gt_requests.h"
 #include "intel_timeline.h"
 
+/*
+ * The maximum number of requests retired by each pass of the engine retire
+ * worker, so that a burst of completions is processed in bounded batches
+ * and does not monopolise the cpu that signaled them.
+ */
+#define ENGINE_RETIRE_BATCH 64
+
 static bool retire_requests(struct intel_timeline *tl)
 {
 	struct i915_request *rq, *rn;
@@ -57,25 +68,56 @@ static bool flush_submission(struct intel_gt *gt, long timeout)
 	return active;
 }
 
+static bool retire_requests_batch(struct intel_timeline *tl,
+				  unsigned int *budget)
+{
+	struct i915_request *rq, *rn;
+
+	list_for_each_entry_safe(rq, rn, &tl->requests, link) {
+		if (!*budget)
+			return false;
+
+		if (!i915_request_retire(rq))
+			break;
+
+		--*budget;
+	}
+
+	return true;
+}
+
+static bool add_retire(struct intel_engine_cs *engine,
+		       struct intel_timeline *tl);
+
 static void engine_retire(struct work_struct *work)
 {
 	struct intel_engine_cs *engine =
 		container_of(work, typeof(*engine), retire_work);
 	struct intel_timeline *tl = xchg(&engine->retire, NULL);
+	unsigned int budget = ENGINE_RETIRE_BATCH;
+	bool requeue = false;
 
 	do {
 		struct intel_timeline *next = xchg(&tl->retire, NULL);
 
 		/*
-		 * Our goal here is to retire _idle_ timelines as soon as
-		 * possible (as they are idle, we do not expect userspace
-		 * to be cleaning up anytime soon).
+		 * Our goal here is to retire completed timelines as soon as
+		 * possible, so that their rings and other resources are
+		 * released promptly after a burst of submission, and _idle_
+		 * timelines in particular (as they are idle, we do not
+		 * expect userspace to be cleaning up anytime soon).
 		 *
 		 * If the timeline is currently locked, either it is being
 		 * retired elsewhere or about to be!
+		 *
+		 * Once we exhaust our budget, we push the remaining
+		 * timelines back onto the queue for the next pass.
 		 */
-		if (mutex_trylock(&tl->mutex)) {
-			retire_requests(tl);
+		if (!budget) {
+			requeue |= add_retire(engine, tl);
+		} else if (mutex_trylock(&tl->mutex)) {
+			if (!retire_requests_batch(tl, &budget))
+				requeue |= add_retire(engine, tl);
 			mutex_unlock(&tl->mutex);
 		}
 		intel_timeline_put(tl);
@@ -83,6 +125,10 @@ static void engine_retire(struct work_struct *work)
 		GEM_BUG_ON(!next);
 		tl = ptr_mask_bits(next, 1);
 	} while (tl);
+
+	if (requeue)
+		queue_work_on(raw_smp_processor_id(),
+			      engine->i915->unordered_wq, &engine->retire_work);
 }
 
 static bool add_retire(struct intel_engine_cs *engine,
@@ -115,8 +161,66 @@ void intel_engine_add_retire(struct intel_engine_cs *engine,
 	/* We don't deal well with the engine disappearing beneath us */
 	GEM_BUG_ON(intel_engine_is_virtual(engine));
 
+	/*
+	 * Typically called from the breadcrumb signaler, we run the retire
+	 * worker on the same cpu so that it finds the requests still hot
+	 * in its cache.
+	 */
 	if (add_retire(engine, tl))
-		queue_work(engine->i915->unordered_wq, &engine->retire_work);
+		queue_work_on(raw_smp_processor_id(),
+			      engine->i915->unordered_wq, &engine->retire_work);
+}
+
+/**
+ * intel_gt_record_retire_latency - account the delay in retiring a request
+ * @gt: the GT executing the request
+ * @signaled: when the request was signaled
+ */
+void intel_gt_record_retire_latency(struct intel_gt *gt, ktime_t signaled)
+{
+	s64 dt = ktime_us_delta(ktime_get(), signaled);
+
+	if (dt < 0)
+		return;
+
+	ewma__retire_latency_add(&gt->requests.latency, dt);
+	if (dt > READ_ONCE(gt->requests.max_latency))
+		WRITE_ONCE(gt->requests.max_latency, dt);
+}
+
+/**
+ * intel_gt_show_retire - report the retirement backlog and latency
+ * @gt: the GT to inspect
+ * @p: where to print
+ */
+void intel_gt_show_retire(struct intel_gt *gt, struct drm_printer *p)
+{
+	struct intel_gt_timelines *timelines = &gt->timelines;
+	unsigned long pending = 0, active = 0;
+	struct intel_timeline *tl;
+
+	/* A snapshot of the completed requests still awaiting retirement */
+	rcu_read_lock();
+	spin_lock(&timelines->lock);
+	list_for_each_entry(tl, &timelines->active_list, link) {
+		struct i915_request *rq;
+
+		list_for_each_entry_rcu(rq, &tl->requests, link) {
+			if (!__i915_request_is_complete(rq)) {
+				active++;
+				break;
+			}
+			pending++;
+		}
+	}
+	spin_unlock(&timelines->lock);
+	rcu_read_unlock();
+
+	drm_printf(p, "Pending retirement: %lu requests\n", pending);
+	drm_printf(p, "Busy timelines: %lu\n", active);
+	drm_printf(p, "Retire latency: %luus (avg), %luus (max)\n",
+		   ewma__retire_latency_read(&gt->requests.latency),
+		   READ_ONCE(gt->requests.max_latency));
 }
 
 void intel_engine_init_retire(struct intel_engine_cs *engine)
@@ -215,6 +319,7 @@ static void retire_work_handler(struct work_struct *work)
 void intel_gt_init_requests(struct intel_gt *gt)
 {
 	INIT_DELAYED_WORK(&gt->requests.retire_work, retire_work_handler);
+	ewma__retire_latency_init(&gt->requests.latency);
 }
 
 void intel_gt_park_requests(struct intel_gt *gt)
@@ -234,6 +339,7 @@ void intel_gt_fini_requests(struct intel_gt *gt)
 	cancel_delayed_work_sync(&gt->requests.retire_work);
 
 	flush_work(&gt->watchdog.work);
+	flush_work(&gt->deadline.work);
 }
 
 void intel_gt_watchdog_work(struct work_struct *work)
@@ -266,3 +372,23 @@ void intel_gt_watchdog_work(struct work_struct *work)
 		i915_request_put(rq);
 	}
 }
+
+void intel_gt_deadline_work(struct work_struct *work)
+{
+	struct intel_gt *gt =
+		container_of(work, typeof(*gt), deadline.work);
+	struct i915_request *rq, *rn;
+	struct llist_node *first;
+
+	first = llist_del_all(&gt->deadline.list);
+	if (!first)
+		return;
+
+	llist_for_each_entry_safe(rq, rn, first, deadline.link) {
+		if (!i915_request_completed(rq)) {
+			atomic_long_inc(&rq->engine->stats.deadline.boost);
+			i915_gem_fence_wait_priority_display(&rq->fence);
+		}
+		i915_request_put(rq);
+	}
+}
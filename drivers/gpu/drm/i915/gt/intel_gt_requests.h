@@ -6,8 +6,10 @@
 #ifndef INTEL_GT_REQUESTS_H
 #define INTEL_GT_REQUESTS_H
 
+#include <linux/ktime.h>
 #include <linux/stddef.h>
 
+struct drm_printer;
 struct intel_engine_cs;
 struct intel_gt;
 struct intel_timeline;
@@ -24,6 +26,9 @@ void intel_engine_add_retire(struct intel_engine_cs *engine,
 			     struct intel_timeline *tl);
 void intel_engine_fini_retire(struct intel_engine_cs *engine);
 
+void intel_gt_record_retire_latency(struct intel_gt *gt, ktime_t signaled);
+void intel_gt_show_retire(struct intel_gt *gt, struct drm_printer *p);
+
 void intel_gt_init_requests(struct intel_gt *gt);
 void intel_gt_park_requests(struct intel_gt *gt);
 void intel_gt_unpark_requests(struct intel_gt *gt);
@@ -34,6 +34,9 @@
 #include "intel_wopcm.h"
 #include "iov/intel_iov_types.h"
 
+/* Time from a request being signaled until it is retired, in us */
+DECLARE_EWMA(_retire_latency, 6, 4)
+
 struct drm_i915_private;
 struct i915_ggtt;
 struct intel_engine_cs;
@@ -135,13 +138,20 @@ struct intel_gt {
 
 	struct intel_gt_requests {
 		/**
-		 * We leave the user IRQ off as much as possible,
-		 * but this means that requests will finish and never
-		 * be retired once the system goes idle. Set a timer to
-		 * fire periodically while the ring is running. When it
-		 * fires, go retire requests.
+		 * Completed timelines are queued for retirement by the
+		 * breadcrumb signaler as their requests are signaled, see
+		 * intel_engine_add_retire(). However, we leave the user IRQ
+		 * off as much as possible, and so requests may finish
+		 * without anyone listening and never be retired once the
+		 * system goes idle. As a fallback, set a timer to fire
+		 * periodically while the ring is running. When it fires,
+		 * go retire requests.
 		 */
 		struct delayed_work retire_work;
+
+		/* Signal to retirement latency, see i915_request_retire() */
+		struct ewma__retire_latency latency;
+		unsigned long max_latency;
 	} requests;
 
 	/**
@@ -156,6 +166,11 @@ struct intel_gt {
 		struct work_struct work;
 	} watchdog;
 
+	struct {
+		struct llist_head list;
+		struct work_struct work;
+	} deadline;
+
 	struct intel_wakeref wakeref;
 	atomic_t user_wakeref;
 
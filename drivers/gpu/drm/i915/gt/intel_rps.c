@@ -14,6 +14,7 @@
 #include "i915_drv.h"
 #include "i915_freq.h"
 #include "i915_irq.h"
+#include "i915_pmu.h"
 #include "i915_reg.h"
 #include "i915_wait_util.h"
 #include "intel_breadcrumbs.h"
@@ -1101,6 +1102,7 @@ int intel_rps_set(struct intel_rps *rps, u8 val)
 	}
 
 	rps->cur_freq = val;
+	i915_pmu_gt_rps_set(rps_to_gt(rps), intel_gpu_freq(rps, val));
 	return 0;
 }
 
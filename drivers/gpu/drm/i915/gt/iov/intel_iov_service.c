@@ -20,14 +20,6 @@
 #include "intel_iov_types.h"
 #include "intel_iov_utils.h"
 
-static void __uncore_read_many(struct intel_uncore *uncore, unsigned int count,
-			       const i915_reg_t *regs, u32 *values)
-{
-	while (count--) {
-		*values++ = intel_uncore_read(uncore, *regs++);
-	}
-}
-
 static const i915_reg_t tgl_runtime_regs[] = {
 	RPM_CONFIG0,			/* _MMIO(0x0D00) */
 	GEN10_MIRROR_FUSE3,		/* _MMIO(0x9118) */
@@ -154,7 +146,7 @@ static void pf_prepare_runtime_info(struct intel_iov *iov)
 	regs = iov->pf.service.runtime.regs;
 	values = iov->pf.service.runtime.values;
 
-	__uncore_read_many(iov_to_gt(iov)->uncore, size, regs, values);
+	intel_uncore_read_many(iov_to_gt(iov)->uncore, regs, values, size);
 
 	while (size--) {
 		IOV_DEBUG(iov, "reg[%#x] = %#x\n",
@@ -216,6 +216,11 @@ struct intel_guc {
 	u32 ads_waklv_size;
 	/** @ads_capture_size: size of register lists in the ADS used for error capture */
 	u32 ads_capture_size;
+	/**
+	 * @ads_template: copy of the fully initialised ADS, restored on
+	 * reset instead of rebuilding it from scratch
+	 */
+	void *ads_template;
 
 	/** @lrc_desc_pool_v69: object allocated to hold the GuC LRC descriptor pool */
 	struct i915_vma *lrc_desc_pool_v69;
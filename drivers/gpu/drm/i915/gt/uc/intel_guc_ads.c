@@ -1008,6 +1008,69 @@ int intel_guc_ads_create(struct intel_guc *guc)
 	return 0;
 }
 
+/*
+ * Everything in the ADS that __guc_ads_init() writes, skipping the engine
+ * usage stats (owned by the GuC and read back for busyness), the golden
+ * contexts (only written once, at init_late) and the private data (zeroed
+ * on each reset).
+ */
+#define GUC_ADS_TEMPLATE_RANGES 3
+
+static void guc_ads_template_ranges(struct intel_guc *guc,
+				    u32 offset[GUC_ADS_TEMPLATE_RANGES],
+				    u32 size[GUC_ADS_TEMPLATE_RANGES])
+{
+	offset[0] = 0;
+	size[0] = offsetof(struct __guc_ads_blob, engine_usage);
+
+	offset[1] = guc_ads_regset_offset(guc);
+	size[1] = guc_ads_golden_ctxt_offset(guc) - offset[1];
+
+	offset[2] = guc_ads_waklv_offset(guc);
+	size[2] = guc_ads_private_data_offset(guc) - offset[2];
+}
+
+static void guc_ads_template_save(struct intel_guc *guc)
+{
+	u32 offset[GUC_ADS_TEMPLATE_RANGES], size[GUC_ADS_TEMPLATE_RANGES];
+	u32 total = 0;
+	void *data;
+	int i;
+
+	guc_ads_template_ranges(guc, offset, size);
+	for (i = 0; i < GUC_ADS_TEMPLATE_RANGES; i++)
+		total += size[i];
+
+	/* Not fatal, we just keep rebuilding the ADS on every reset */
+	data = kmalloc(total, GFP_KERNEL | __GFP_NOWARN);
+	if (!data)
+		return;
+
+	guc->ads_template = data;
+	for (i = 0; i < GUC_ADS_TEMPLATE_RANGES; i++) {
+		iosys_map_memcpy_from(data, &guc->ads_map, offset[i], size[i]);
+		data += size[i];
+	}
+}
+
+static void guc_ads_template_restore(struct intel_guc *guc)
+{
+	u32 offset[GUC_ADS_TEMPLATE_RANGES], size[GUC_ADS_TEMPLATE_RANGES];
+	const void *data = guc->ads_template;
+	int i;
+
+	guc_ads_template_ranges(guc, offset, size);
+	for (i = 0; i < GUC_ADS_TEMPLATE_RANGES; i++) {
+		iosys_map_memcpy_to(&guc->ads_map, offset[i], data, size[i]);
+		data += size[i];
+	}
+
+	/* The reset policy follows the modparam, which may have changed */
+	guc_policies_init(guc);
+
+	i915_gem_object_flush_map(guc->ads_vma->obj);
+}
+
 void intel_guc_ads_init_late(struct intel_guc *guc)
 {
 	/*
@@ -1018,12 +1081,21 @@ void intel_guc_ads_init_late(struct intel_guc *guc)
 	 * occurs, so it can be filled in during this late init phase.
 	 */
 	guc_init_golden_context(guc);
+
+	/*
+	 * The ADS is now complete and, bar the policies, only depends on
+	 * the platform, so keep a copy of it to speed up later reloads.
+	 */
+	if (!guc->ads_template)
+		guc_ads_template_save(guc);
 }
 
 void intel_guc_ads_destroy(struct intel_guc *guc)
 {
 	i915_vma_unpin_and_release(&guc->ads_vma, I915_VMA_RELEASE_MAP);
 	iosys_map_clear(&guc->ads_map);
+	kfree(guc->ads_template);
+	guc->ads_template = NULL;
 	kfree(guc->ads_regset);
 }
 
@@ -1045,14 +1117,18 @@ static void guc_ads_private_data_reset(struct intel_guc *guc)
  *
  * GuC stores some data in ADS, which might be stale after a reset.
  * Reinitialize whole ADS in case any part of it was corrupted during
- * previous GuC run.
+ * previous GuC run. Once the ADS has been fully initialised, it is
+ * restored from the saved copy rather than rebuilt.
  */
 void intel_guc_ads_reset(struct intel_guc *guc)
 {
 	if (!guc->ads_vma)
 		return;
 
-	__guc_ads_init(guc);
+	if (guc->ads_template)
+		guc_ads_template_restore(guc);
+	else
+		__guc_ads_init(guc);
 
 	guc_ads_private_data_reset(guc);
 }
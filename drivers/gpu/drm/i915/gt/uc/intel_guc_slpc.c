@@ -34,6 +34,13 @@
  * Another form of frequency control happens through per-context hints.
  * A context can be marked as low latency during creation. That will ensure
  * that SLPC uses an aggressive frequency ramp when that context is active.
+ * Separately, the context priority places it in a workload class: above
+ * the default priority it is latency sensitive, below it throughput
+ * oriented. KMD counts the active contexts of each class on the GT and,
+ * while any are active, raises the min frequency to the boost frequency
+ * for latency, or to the efficient frequency (RP1) for throughput. The floor is raised promptly
+ * but only lowered once the class has been idle for a short while, and
+ * the updates sent to GuC are rate limited.
  *
  * Power profiles add another level of control to these mechanisms.
  * When power saving profile is chosen, SLPC will use conservative
@@ -252,6 +259,165 @@ static int slpc_force_min_freq(struct intel_guc_slpc *slpc, u32 freq)
 	return ret;
 }
 
+/* Keep the floor of a class for this long after it goes idle */
+#define SLPC_HINT_HOLD_MS 50
+/* And send at most one update to GuC per interval */
+#define SLPC_HINT_INTERVAL_MS 10
+
+static const char * const slpc_hint_names[SLPC_HINT_COUNT] = {
+	[SLPC_HINT_NONE] = "none",
+	[SLPC_HINT_THROUGHPUT] = "throughput",
+	[SLPC_HINT_LATENCY] = "latency",
+};
+
+static u32 slpc_hint_freq(struct intel_guc_slpc *slpc,
+			  enum slpc_hint_class class)
+{
+	switch (class) {
+	case SLPC_HINT_LATENCY:
+		return slpc->boost_freq;
+	case SLPC_HINT_THROUGHPUT:
+		return slpc->rp1_freq;
+	default:
+		return 0;
+	}
+}
+
+/* The lowest min frequency we may currently request, outside of waitboost */
+static u32 slpc_floor_freq(struct intel_guc_slpc *slpc)
+{
+	lockdep_assert_held(&slpc->lock);
+
+	return max(slpc->min_freq_softlimit, slpc->hint.freq);
+}
+
+static enum slpc_hint_class slpc_hint_active(struct intel_guc_slpc *slpc)
+{
+	enum slpc_hint_class class;
+
+	for (class = SLPC_HINT_COUNT - 1; class > SLPC_HINT_NONE; class--)
+		if (atomic_read(&slpc->hint.active[class]))
+			break;
+
+	return class;
+}
+
+static void slpc_hint_residency(struct intel_guc_slpc *slpc,
+				enum slpc_hint_class class)
+{
+	ktime_t now = ktime_get();
+
+	lockdep_assert_held(&slpc->lock);
+
+	slpc->hint.residency[slpc->hint.class] =
+		ktime_add(slpc->hint.residency[slpc->hint.class],
+			  ktime_sub(now, slpc->hint.since));
+	slpc->hint.since = now;
+	slpc->hint.class = class;
+}
+
+static void slpc_hint_work(struct work_struct *work)
+{
+	struct intel_guc_slpc *slpc =
+		container_of(work, typeof(*slpc), hint.work.work);
+	struct drm_i915_private *i915 = slpc_to_i915(slpc);
+	enum slpc_hint_class class;
+	unsigned long delay;
+	u32 freq;
+
+	mutex_lock(&slpc->lock);
+
+	/* Hysteresis: hold onto a higher floor until its class settles */
+	class = slpc_hint_active(slpc);
+	if (class < slpc->hint.class) {
+		delay = READ_ONCE(slpc->hint.idle) +
+			msecs_to_jiffies(SLPC_HINT_HOLD_MS);
+		if (time_before(jiffies, delay)) {
+			queue_delayed_work(i915->unordered_wq, &slpc->hint.work,
+					   delay - jiffies);
+			goto unlock;
+		}
+	}
+
+	if (class != slpc->hint.class)
+		slpc_hint_residency(slpc, class);
+
+	freq = slpc_hint_freq(slpc, class);
+	if (freq == slpc->hint.freq)
+		goto unlock;
+
+	slpc->hint.freq = freq;
+
+	/* An outstanding waitboost already holds min at the boost freq */
+	if (atomic_read(&slpc->num_waiters) &&
+	    slpc->boost_freq >= slpc_floor_freq(slpc))
+		goto unlock;
+
+	if (!slpc_force_min_freq(slpc, slpc_floor_freq(slpc))) {
+		slpc->hint.num_updates++;
+		WRITE_ONCE(slpc->hint.last, jiffies);
+	}
+
+unlock:
+	mutex_unlock(&slpc->lock);
+}
+
+static void slpc_hint_queue(struct intel_guc_slpc *slpc, unsigned long delay)
+{
+	struct workqueue_struct *wq = slpc_to_i915(slpc)->unordered_wq;
+	struct delayed_work *dwork = &slpc->hint.work;
+	unsigned long next = READ_ONCE(slpc->hint.last) +
+			     msecs_to_jiffies(SLPC_HINT_INTERVAL_MS);
+
+	/* Rate limit the H2G, coalescing changes into the pending update */
+	if (time_before(jiffies, next))
+		delay = max(delay, next - jiffies);
+
+	/*
+	 * A pending update may be waiting out the hold period of a class that
+	 * went idle; pull it in if we now need to act sooner, e.g. to raise
+	 * the floor for a newly active class.
+	 */
+	if (delayed_work_pending(dwork) &&
+	    time_before(jiffies + delay, READ_ONCE(dwork->timer.expires)))
+		mod_delayed_work(wq, dwork, delay);
+	else
+		queue_delayed_work(wq, dwork, delay);
+}
+
+/**
+ * intel_guc_slpc_hint_get - mark a context of the given class as active
+ * @slpc: pointer to intel_guc_slpc
+ * @class: the workload class declared by the context
+ *
+ * Called as a hinted context becomes active on the GT. The first active
+ * context of a class raises the min frequency floor for that class.
+ */
+void intel_guc_slpc_hint_get(struct intel_guc_slpc *slpc,
+			     enum slpc_hint_class class)
+{
+	GEM_BUG_ON(class <= SLPC_HINT_NONE || class >= SLPC_HINT_COUNT);
+
+	if (!atomic_fetch_inc(&slpc->hint.active[class]))
+		slpc_hint_queue(slpc, 0);
+}
+
+/**
+ * intel_guc_slpc_hint_put - mark a context of the given class as idle
+ * @slpc: pointer to intel_guc_slpc
+ * @class: the workload class declared by the context
+ */
+void intel_guc_slpc_hint_put(struct intel_guc_slpc *slpc,
+			     enum slpc_hint_class class)
+{
+	GEM_BUG_ON(class <= SLPC_HINT_NONE || class >= SLPC_HINT_COUNT);
+
+	if (atomic_dec_and_test(&slpc->hint.active[class])) {
+		WRITE_ONCE(slpc->hint.idle, jiffies);
+		slpc_hint_queue(slpc, msecs_to_jiffies(SLPC_HINT_HOLD_MS));
+	}
+}
+
 static void slpc_boost_work(struct work_struct *work)
 {
 	struct intel_guc_slpc *slpc = container_of(work, typeof(*slpc), boost_work);
@@ -298,8 +464,13 @@ int intel_guc_slpc_init(struct intel_guc_slpc *slpc)
 
 	slpc->power_profile = SLPC_POWER_PROFILES_BASE;
 
+	slpc->hint.class = SLPC_HINT_NONE;
+	slpc->hint.freq = 0;
+	slpc->hint.since = ktime_get();
+
 	mutex_init(&slpc->lock);
 	INIT_WORK(&slpc->boost_work, slpc_boost_work);
+	INIT_DELAYED_WORK(&slpc->hint.work, slpc_hint_work);
 
 	return err;
 }
@@ -541,6 +712,10 @@ int intel_guc_slpc_set_min_freq(struct intel_guc_slpc *slpc, u32 val)
 	if (!ret)
 		slpc->min_freq_softlimit = val;
 
+	/* Keep the floor requested by any active workload hints */
+	if (!ret && slpc->hint.freq > val)
+		slpc_force_min_freq(slpc, slpc->hint.freq);
+
 	intel_runtime_pm_put(&i915->runtime_pm, wakeref);
 	mutex_unlock(&slpc->lock);
 
@@ -804,6 +979,12 @@ int intel_guc_slpc_enable(struct intel_guc_slpc *slpc)
 		return ret;
 	}
 
+	/* Reapply the floor for any hinted contexts that are still active */
+	mutex_lock(&slpc->lock);
+	slpc->hint.freq = 0;
+	mutex_unlock(&slpc->lock);
+	slpc_hint_queue(slpc, 0);
+
 	return 0;
 }
 
@@ -844,7 +1025,7 @@ void intel_guc_slpc_dec_waiters(struct intel_guc_slpc *slpc)
 	 */
 	mutex_lock(&slpc->lock);
 	if (atomic_dec_and_test(&slpc->num_waiters))
-		slpc_force_min_freq(slpc, slpc->min_freq_softlimit);
+		slpc_force_min_freq(slpc, slpc_floor_freq(slpc));
 	mutex_unlock(&slpc->lock);
 }
 
@@ -855,6 +1036,7 @@ int intel_guc_slpc_print_info(struct intel_guc_slpc *slpc, struct drm_printer *p
 	struct slpc_task_state_data *slpc_tasks;
 	intel_wakeref_t wakeref;
 	int ret = 0;
+	int i;
 
 	GEM_BUG_ON(!slpc->vma);
 
@@ -895,6 +1077,18 @@ int intel_guc_slpc_print_info(struct intel_guc_slpc *slpc, struct drm_printer *p
 		}
 	}
 
+	mutex_lock(&slpc->lock);
+	slpc_hint_residency(slpc, slpc->hint.class);
+	drm_printf(p, "\tWorkload hint: %s, min freq %u MHz, %u updates\n",
+		   slpc_hint_names[slpc->hint.class], slpc->hint.freq,
+		   slpc->hint.num_updates);
+	for (i = SLPC_HINT_NONE; i < SLPC_HINT_COUNT; i++)
+		drm_printf(p, "\tHint %s: %d active, %llu ms residency\n",
+			   slpc_hint_names[i],
+			   atomic_read(&slpc->hint.active[i]),
+			   ktime_to_ms(slpc->hint.residency[i]));
+	mutex_unlock(&slpc->lock);
+
 	return ret;
 }
 
@@ -903,5 +1097,6 @@ void intel_guc_slpc_fini(struct intel_guc_slpc *slpc)
 	if (!slpc->vma)
 		return;
 
+	cancel_delayed_work_sync(&slpc->hint.work);
 	i915_vma_unpin_and_release(&slpc->vma, I915_VMA_RELEASE_MAP);
 }
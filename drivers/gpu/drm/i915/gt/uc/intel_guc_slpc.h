@@ -44,6 +44,10 @@ int intel_guc_slpc_set_media_ratio_mode(struct intel_guc_slpc *slpc, u32 val);
 void intel_guc_pm_intrmsk_enable(struct intel_gt *gt);
 void intel_guc_slpc_boost(struct intel_guc_slpc *slpc);
 void intel_guc_slpc_dec_waiters(struct intel_guc_slpc *slpc);
+void intel_guc_slpc_hint_get(struct intel_guc_slpc *slpc,
+			     enum slpc_hint_class class);
+void intel_guc_slpc_hint_put(struct intel_guc_slpc *slpc,
+			     enum slpc_hint_class class);
 int intel_guc_slpc_set_ignore_eff_freq(struct intel_guc_slpc *slpc, bool val);
 int intel_guc_slpc_set_strategy(struct intel_guc_slpc *slpc, u32 val);
 int intel_guc_slpc_set_power_profile(struct intel_guc_slpc *slpc, u32 val);
@@ -13,6 +13,17 @@
 
 #define SLPC_RESET_TIMEOUT_MS 5
 
+/*
+ * Workload classes declared by userspace contexts, in increasing order of
+ * the frequency floor they request while active.
+ */
+enum slpc_hint_class {
+	SLPC_HINT_NONE = 0,
+	SLPC_HINT_THROUGHPUT,
+	SLPC_HINT_LATENCY,
+	SLPC_HINT_COUNT
+};
+
 struct intel_guc_slpc {
 	struct i915_vma *vma;
 	struct slpc_shared_data *vaddr;
@@ -47,6 +58,21 @@ struct intel_guc_slpc {
 	struct work_struct boost_work;
 	atomic_t num_waiters;
 	u32 num_boosts;
+
+	/* Aggregated workload hints of the active contexts on this GT */
+	struct {
+		atomic_t active[SLPC_HINT_COUNT];
+		unsigned long idle; /* jiffies when a class last went idle */
+		unsigned long last; /* jiffies of the last H2G update */
+		struct delayed_work work;
+
+		/* Protected by slpc->lock */
+		enum slpc_hint_class class;
+		u32 freq;
+		u32 num_updates;
+		ktime_t since;
+		ktime_t residency[SLPC_HINT_COUNT];
+	} hint;
 };
 
 #endif
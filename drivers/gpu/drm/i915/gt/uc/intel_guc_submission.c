@@ -64,6 +64,16 @@
  * which informs the GuC that a previously enabled context has new work
  * available.
  *
+ * Doorbells:
+ * Older GuC interfaces let the i915 bind a HW doorbell to a client and
+ * submit by ringing it instead of sending a H2G. The v70 context
+ * registration has no doorbell binding, so every submission after the
+ * schedule enable still costs a context submit H2G. The doorbell ranges
+ * provisioned to VFs (see intel_iov_provisioning_set_dbs()) are only passed
+ * on to the GuC, and the i915 never rings a doorbell itself. Skipping the
+ * H2G for a context that is still queued is not safe either, as we cannot
+ * tell whether the GuC has already sampled the LRC tail.
+ *
  * Context unpin:
  * To unpin a context a H2G is used to disable scheduling. When the
  * corresponding G2H returns indicating the scheduling disable operation has
@@ -1487,17 +1497,34 @@ static void __update_guc_busyness_stats(struct intel_guc *guc)
 	spin_unlock_irqrestore(&guc->timestamp.lock, flags);
 }
 
+/*
+ * The usage record and the context image are updated independently, so around
+ * a switch out the same interval may briefly be seen in both. Never let the
+ * reported runtime go backwards once that resolves.
+ */
+static void __guc_context_set_live(struct intel_context *ce, u64 reported,
+				   u64 live)
+{
+	if (ce->stats.runtime.total + live < reported)
+		live = reported - ce->stats.runtime.total;
+
+	WRITE_ONCE(ce->stats.runtime.live, live);
+}
+
 static void __guc_context_update_stats(struct intel_context *ce)
 {
 	struct intel_guc *guc = ce_to_guc(ce);
 	unsigned long flags;
+	u64 reported;
 
 	spin_lock_irqsave(&guc->timestamp.lock, flags);
+	reported = ce->stats.runtime.total + ce->stats.runtime.live;
 	lrc_update_runtime(ce);
+	__guc_context_set_live(ce, reported, 0);
 	spin_unlock_irqrestore(&guc->timestamp.lock, flags);
 }
 
-static void guc_context_update_stats(struct intel_context *ce)
+static void guc_context_update_runtime(struct intel_context *ce)
 {
 	if (!intel_context_pin_if_active(ce))
 		return;
@@ -1506,6 +1533,85 @@ static void guc_context_update_stats(struct intel_context *ce)
 	intel_context_unpin(ce);
 }
 
+/*
+ * The context image only holds the runtime accumulated up to the last switch
+ * out, so a context that is currently executing is missing everything since
+ * its last switch in. GuC publishes the id and switch-in stamp of the context
+ * running on each engine in the engine usage record, so we can compute the
+ * in-flight portion directly from the shared mapping when asked, rather than
+ * waiting for the context to be switched out.
+ */
+static u64 __guc_context_live_clks(struct intel_context *ce)
+{
+	struct intel_guc *guc = ce_to_guc(ce);
+	struct intel_engine_cs *engine;
+	intel_engine_mask_t tmp;
+	u32 last_in, id, total;
+	ktime_t unused;
+	u64 start;
+
+	lockdep_assert_held(&guc->timestamp.lock);
+
+	for_each_engine_masked(engine, ce->engine->gt, ce->engine->mask, tmp) {
+		__get_engine_usage_record(engine, &last_in, &id, &total);
+		if (id != ce->guc_id.id || !last_in)
+			continue;
+
+		guc_update_pm_timestamp(guc, &unused);
+
+		start = 0;
+		__extend_last_switch(guc, &start, last_in);
+		if (guc->timestamp.gt_stamp <= start)
+			return 0;
+
+		return guc->timestamp.gt_stamp - start;
+	}
+
+	return 0;
+}
+
+static void guc_context_update_stats(struct intel_context *ce)
+{
+	struct intel_gt *gt = ce->engine->gt;
+	struct intel_guc *guc = gt_to_guc(gt);
+	struct i915_gpu_error *gpu_error = &gt->i915->gpu_error;
+	intel_wakeref_t wakeref;
+	unsigned long flags;
+	u32 reset_count;
+	u64 reported, live = 0;
+
+	if (!intel_context_pin_if_active(ce))
+		return;
+
+	spin_lock_irqsave(&guc->timestamp.lock, flags);
+
+	reported = ce->stats.runtime.total + ce->stats.runtime.live;
+	lrc_update_runtime(ce);
+
+	/*
+	 * Nothing can be executing while the gt is parked, and during a reset
+	 * the usage record may be partially updated; in both cases the context
+	 * image is all we have. See guc_engine_busyness().
+	 */
+	reset_count = i915_reset_count(gpu_error);
+	wakeref = test_bit(I915_RESET_BACKOFF, &gt->reset.flags) ?
+		NULL : intel_gt_pm_get_if_awake(gt);
+	if (wakeref) {
+		if (!IS_SRIOV_VF(gt->i915) &&
+		    ce->guc_id.id != GUC_INVALID_CONTEXT_ID)
+			live = __guc_context_live_clks(ce);
+		intel_gt_pm_put_async(gt, wakeref);
+		if (i915_reset_count(gpu_error) != reset_count)
+			live = 0;
+	}
+
+	__guc_context_set_live(ce, reported, live);
+
+	spin_unlock_irqrestore(&guc->timestamp.lock, flags);
+
+	intel_context_unpin(ce);
+}
+
 static void guc_timestamp_ping(struct work_struct *wrk)
 {
 	struct intel_guc *guc = container_of(wrk, typeof(*guc),
@@ -1561,7 +1667,7 @@ static void guc_timestamp_ping(struct work_struct *wrk)
 
 	/* adjust context stats for overflow */
 	xa_for_each(&guc->context_lookup, index, ce)
-		guc_context_update_stats(ce);
+		guc_context_update_runtime(ce);
 
 	intel_gt_reset_unlock(gt, srcu);
 
@@ -3913,6 +4019,28 @@ static inline void sub_context_inflight_prio(struct intel_context *ce,
 	--ce->guc_state.prio_count[guc_prio];
 }
 
+/*
+ * Transient boosts, e.g. for a dma_fence deadline, would otherwise cost a
+ * pair of H2G for every boosted request. Raising the band is always
+ * immediate, but we hold on to it for a little while afterwards and defer
+ * lowering it until the hold expires.
+ */
+#define GUC_PRIO_HOLD_JIFFIES msecs_to_jiffies(2)
+
+static void queue_context_prio_work(struct intel_context *ce)
+{
+	unsigned long delay = ce->guc_state.prio_raised +
+			      GUC_PRIO_HOLD_JIFFIES - jiffies;
+
+	lockdep_assert_held(&ce->guc_state.lock);
+
+	/* The caller holds a reference, so this is never the last put */
+	intel_context_get(ce);
+	if (!queue_delayed_work(system_unbound_wq,
+				&ce->guc_state.prio_work, delay))
+		intel_context_put(ce);
+}
+
 static inline void update_context_prio(struct intel_context *ce)
 {
 	struct intel_guc *guc = &ce->engine->gt->uc.guc;
@@ -3924,13 +4052,48 @@ static inline void update_context_prio(struct intel_context *ce)
 	lockdep_assert_held(&ce->guc_state.lock);
 
 	for (i = 0; i < ARRAY_SIZE(ce->guc_state.prio_count); ++i) {
-		if (ce->guc_state.prio_count[i]) {
-			guc_context_set_prio(guc, ce, i);
+		if (!ce->guc_state.prio_count[i])
+			continue;
+
+		if (i < ce->guc_state.prio)
+			ce->guc_state.prio_raised = jiffies;
+		else if (i > ce->guc_state.prio &&
+			 time_before(jiffies, ce->guc_state.prio_raised +
+				     GUC_PRIO_HOLD_JIFFIES)) {
+			queue_context_prio_work(ce);
 			break;
 		}
+
+		guc_context_set_prio(guc, ce, i);
+		break;
 	}
 }
 
+static void __guc_context_prio_work(struct work_struct *wrk)
+{
+	struct intel_context *ce =
+		container_of(wrk, typeof(*ce), guc_state.prio_work.work);
+	struct intel_runtime_pm *runtime_pm = &ce->engine->gt->i915->runtime_pm;
+	intel_wakeref_t wakeref;
+	unsigned long flags;
+
+	/*
+	 * Don't wake the device just to lower a band; if it is asleep, the
+	 * context has nothing in flight for the band to matter, and it is
+	 * re-evaluated as soon as a request is next added or removed.
+	 */
+	wakeref = intel_runtime_pm_get_if_in_use(runtime_pm);
+	if (wakeref) {
+		spin_lock_irqsave(&ce->guc_state.lock, flags);
+		update_context_prio(ce);
+		spin_unlock_irqrestore(&ce->guc_state.lock, flags);
+
+		intel_runtime_pm_put(runtime_pm, wakeref);
+	}
+
+	intel_context_put(ce);
+}
+
 static inline bool new_guc_prio_higher(u8 old_guc_prio, u8 new_guc_prio)
 {
 	/* Lower value is higher priority */
@@ -4085,9 +4248,11 @@ static void guc_context_init(struct intel_context *ce)
 	rcu_read_unlock();
 
 	ce->guc_state.prio = map_i915_prio_to_guc_prio(prio);
+	ce->guc_state.prio_raised = jiffies - GUC_PRIO_HOLD_JIFFIES;
 
 	INIT_DELAYED_WORK(&ce->guc_state.sched_disable_delay_work,
 			  __delay_sched_disable);
+	INIT_DELAYED_WORK(&ce->guc_state.prio_work, __guc_context_prio_work);
 
 	set_bit(CONTEXT_GUC_INIT, &ce->flags);
 }
@@ -439,12 +439,24 @@ static void print_fw_ver(struct intel_gt *gt, struct intel_uc_fw *fw)
 		fw->file_selected.ver.patch);
 }
 
+/* Returns the time since *start, and restarts the clock for the next phase */
+static ktime_t uc_phase(ktime_t *start)
+{
+	ktime_t now = ktime_get();
+	ktime_t dt = ktime_sub(now, *start);
+
+	*start = now;
+	return dt;
+}
+
 static int __uc_init_hw(struct intel_uc *uc)
 {
+	struct intel_uc_load_times *times = &uc->load_times;
 	struct intel_gt *gt = uc_to_gt(uc);
 	struct drm_i915_private *i915 = gt->i915;
 	struct intel_guc *guc = &uc->guc;
 	struct intel_huc *huc = &uc->huc;
+	ktime_t start, phase;
 	int ret, attempts;
 	bool pl1en = false;
 
@@ -482,6 +494,10 @@ static int __uc_init_hw(struct intel_uc *uc)
 
 	intel_rps_raise_unslice(&uc_to_gt(uc)->rps);
 
+	memset(times, 0, sizeof(*times));
+	start = ktime_get();
+	phase = start;
+
 	while (attempts--) {
 		/*
 		 * Always reset the GuC just before (re)loading, so
@@ -491,10 +507,14 @@ static int __uc_init_hw(struct intel_uc *uc)
 		if (ret)
 			goto err_rps;
 
+		uc_phase(&phase);
 		intel_huc_fw_upload(huc);
+		times->huc = ktime_add(times->huc, uc_phase(&phase));
 		intel_guc_ads_reset(guc);
 		intel_guc_write_params(guc);
+		times->ads = ktime_add(times->ads, uc_phase(&phase));
 		ret = intel_guc_fw_upload(guc);
+		times->guc = ktime_add(times->guc, uc_phase(&phase));
 		if (ret == 0)
 			break;
 
@@ -509,6 +529,7 @@ static int __uc_init_hw(struct intel_uc *uc)
 	ret = guc_enable_communication(guc);
 	if (ret)
 		goto err_log_capture;
+	times->ct = uc_phase(&phase);
 
 	/*
 	 * GSC-loaded HuC is authenticated by the GSC, so we don't need to
@@ -526,6 +547,7 @@ static int __uc_init_hw(struct intel_uc *uc)
 		if (ret)
 			goto err_log_capture;
 	}
+	times->submission = uc_phase(&phase);
 
 	if (intel_uc_uses_guc_slpc(uc)) {
 		ret = intel_guc_slpc_enable(&guc->slpc);
@@ -535,9 +557,17 @@ static int __uc_init_hw(struct intel_uc *uc)
 		/* Restore GT back to RPn for non-SLPC path */
 		intel_rps_lower_unslice(&uc_to_gt(uc)->rps);
 	}
+	times->slpc = uc_phase(&phase);
+	times->total = ktime_sub(phase, start);
 
 	i915_hwmon_power_max_restore(gt->i915, pl1en);
 
+	gt_dbg(gt, "uC loaded in %lldus: huc %lldus, ads %lldus, guc %lldus, ct %lldus, submission %lldus, slpc %lldus\n",
+	       ktime_to_us(times->total), ktime_to_us(times->huc),
+	       ktime_to_us(times->ads), ktime_to_us(times->guc),
+	       ktime_to_us(times->ct), ktime_to_us(times->submission),
+	       ktime_to_us(times->slpc));
+
 	guc_info(guc, "submission %s\n", str_enabled_disabled(intel_uc_uses_guc_submission(uc)));
 	guc_info(guc, "SLPC %s\n", str_enabled_disabled(intel_uc_uses_guc_slpc(uc)));
 
@@ -36,6 +36,17 @@ struct intel_uc {
 	/* Snapshot of GuC log from last failed load */
 	struct drm_i915_gem_object *load_err_log;
 
+	/* Time spent in each phase of the last firmware load */
+	struct intel_uc_load_times {
+		ktime_t huc;
+		ktime_t ads;
+		ktime_t guc;
+		ktime_t ct;
+		ktime_t submission;
+		ktime_t slpc;
+		ktime_t total;
+	} load_times;
+
 	bool reset_in_progress;
 	bool fw_table_invalid;
 };
@@ -37,10 +37,29 @@ static int uc_usage_show(struct seq_file *m, void *data)
 }
 DEFINE_INTEL_GT_DEBUGFS_ATTRIBUTE(uc_usage);
 
+static int uc_load_times_show(struct seq_file *m, void *data)
+{
+	struct intel_uc *uc = m->private;
+	const struct intel_uc_load_times *times = &uc->load_times;
+	struct drm_printer p = drm_seq_file_printer(m);
+
+	drm_printf(&p, "huc: %lldus\n", ktime_to_us(times->huc));
+	drm_printf(&p, "ads: %lldus\n", ktime_to_us(times->ads));
+	drm_printf(&p, "guc: %lldus\n", ktime_to_us(times->guc));
+	drm_printf(&p, "ct: %lldus\n", ktime_to_us(times->ct));
+	drm_printf(&p, "submission: %lldus\n", ktime_to_us(times->submission));
+	drm_printf(&p, "slpc: %lldus\n", ktime_to_us(times->slpc));
+	drm_printf(&p, "total: %lldus\n", ktime_to_us(times->total));
+
+	return 0;
+}
+DEFINE_INTEL_GT_DEBUGFS_ATTRIBUTE(uc_load_times);
+
 void intel_uc_debugfs_register(struct intel_uc *uc, struct dentry *gt_root)
 {
 	static const struct intel_gt_debugfs_file files[] = {
 		{ .name = "usage", .fops = &uc_usage_fops },
+		{ .name = "load_times", .fops = &uc_load_times_fops },
 	};
 	struct dentry *root;
 
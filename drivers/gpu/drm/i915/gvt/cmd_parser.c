@@ -520,8 +520,67 @@ struct parser_exec_state {
 	const struct cmd_info *info;
 
 	struct intel_vgpu_workload *workload;
+
+	/* batch buffers (1st and 2nd level) being scanned for the bb cache */
+	struct bb_scan {
+		void *va;
+		unsigned long gma;
+		unsigned long size;
+		unsigned long end_offset;
+		bool ppgtt;
+		bool tainted;
+	} bb_scan[2];
 };
 
+/*
+ * Batch buffer cache
+ *
+ * Guests resubmit the same batch buffers over and over (static state setup,
+ * media pipelines), each time paying for find_bb_size(), the shadow copy and
+ * the full audit. A batch buffer whose audit had no side effects, i.e. it
+ * needed no patching, raised no events and neither called nor chained to
+ * another batch buffer, is remembered per engine by its guest address. When
+ * the guest submits it again, its current contents are compared against the
+ * audited copy; if unchanged, the shadow is filled from the cache and the
+ * scan resumes directly at its MI_BATCH_BUFFER_END.
+ *
+ * The guest contents are always compared rather than write-protecting the
+ * guest pages, as a batch buffer may also be rewritten through the aperture
+ * or by the GPU itself, neither of which page tracking would catch.
+ */
+#define GVT_BB_CACHE_ENTRIES	32
+#define GVT_BB_CACHE_MAX_SIZE	SZ_64K
+
+struct intel_vgpu_bb_cache_entry {
+	struct list_head link;
+	unsigned long gma;
+	unsigned long size;
+	unsigned long end_offset;
+	bool ppgtt;
+	u8 data[];
+};
+
+static inline struct bb_scan *bb_scan(struct parser_exec_state *s)
+{
+	switch (s->buf_type) {
+	case BATCH_BUFFER_INSTRUCTION:
+		return &s->bb_scan[0];
+	case BATCH_BUFFER_2ND_LEVEL:
+		return &s->bb_scan[1];
+	default:
+		return NULL;
+	}
+}
+
+/* The batch buffer being scanned can't be replayed from the cache */
+static inline void bb_cache_taint(struct parser_exec_state *s)
+{
+	struct bb_scan *scan = bb_scan(s);
+
+	if (scan)
+		scan->tainted = true;
+}
+
 #define gmadr_dw_number(s)	\
 	(s->vgpu->gvt->device_info.gmadr_bytes_in_cmd >> 2)
 
@@ -846,6 +905,7 @@ static inline int cmd_length(struct parser_exec_state *s)
 /* do not remove this, some platform may need clflush here */
 #define patch_value(s, addr, val) do { \
 	*addr = val; \
+	bb_cache_taint(s); \
 } while (0)
 
 static inline bool is_mocs_mmio(unsigned int offset)
@@ -957,7 +1017,9 @@ static int cmd_reg_handler(struct parser_exec_state *s,
 	if (strncmp(cmd, "lri", 3))
 		return -EPERM;
 
-	/* below are all lri handlers */
+	/* below are all lri handlers, which may update vgpu state */
+	bb_cache_taint(s);
+
 	vreg = &vgpu_vreg(s->vgpu, offset);
 
 	if (is_cmd_update_pdps(offset, s) &&
@@ -1230,9 +1292,11 @@ static int cmd_handler_pipe_control(struct parser_exec_state *s)
 	if (ret)
 		return ret;
 
-	if (cmd_val(s, 1) & PIPE_CONTROL_NOTIFY)
+	if (cmd_val(s, 1) & PIPE_CONTROL_NOTIFY) {
 		set_bit(cmd_interrupt_events[s->engine->id].pipe_control_notify,
 			s->workload->pending_events);
+		bb_cache_taint(s);
+	}
 	return 0;
 }
 
@@ -1249,10 +1313,20 @@ static int cmd_advance_default(struct parser_exec_state *s)
 	return ip_gma_advance(s, cmd_length(s));
 }
 
+static void bb_cache_insert(struct parser_exec_state *s,
+			    const struct bb_scan *scan);
+
 static int cmd_handler_mi_batch_buffer_end(struct parser_exec_state *s)
 {
+	struct bb_scan *scan = bb_scan(s);
 	int ret;
 
+	if (scan && scan->va) {
+		if (!scan->tainted && s->ip_va == scan->va + scan->end_offset)
+			bb_cache_insert(s, scan);
+		scan->va = NULL;
+	}
+
 	if (s->buf_type == BATCH_BUFFER_2ND_LEVEL) {
 		s->buf_type = BATCH_BUFFER_INSTRUCTION;
 		ret = ip_gma_set(s, s->ret_ip_gma_bb);
@@ -1488,6 +1562,8 @@ static int cmd_handler_mi_display_flip(struct parser_exec_state *s)
 	int len = cmd_length(s);
 	u32 valid_len = CMD_LEN(1);
 
+	bb_cache_taint(s);
+
 	/* Flip Type == Stereo 3D Flip */
 	if (DWORD_FIELD(2, 1, 0) == 2)
 		valid_len++;
@@ -1753,9 +1829,11 @@ static int cmd_handler_mi_flush_dw(struct parser_exec_state *s)
 		}
 	}
 	/* Check notify bit */
-	if ((cmd_val(s, 0) & (1 << 8)))
+	if ((cmd_val(s, 0) & (1 << 8))) {
 		set_bit(cmd_interrupt_events[s->engine->id].mi_flush_dw,
 			s->workload->pending_events);
+		bb_cache_taint(s);
+	}
 	return ret;
 }
 
@@ -1795,6 +1873,130 @@ static int copy_gma_to_hva(struct intel_vgpu *vgpu, struct intel_vgpu_mm *mm,
 	return len;
 }
 
+static void bb_cache_free(struct intel_vgpu_submission *s, int ring_id,
+			  struct intel_vgpu_bb_cache_entry *e)
+{
+	list_del(&e->link);
+	s->bb_cache[ring_id].count--;
+	kvfree(e);
+}
+
+/* Compare the guest batch buffer against the audited copy */
+static bool bb_cache_match(struct intel_vgpu *vgpu, struct intel_vgpu_mm *mm,
+			   const struct intel_vgpu_bb_cache_entry *e)
+{
+	unsigned long gma = e->gma, end_gma = e->gma + e->size;
+	const u8 *data = e->data;
+	unsigned long offset, len, gpa;
+	bool match = true;
+	void *buf;
+
+	buf = kmalloc(I915_GTT_PAGE_SIZE, GFP_KERNEL);
+	if (!buf)
+		return false;
+
+	while (gma != end_gma) {
+		gpa = intel_vgpu_gma_to_gpa(mm, gma);
+		if (gpa == INTEL_GVT_INVALID_ADDR) {
+			match = false;
+			break;
+		}
+
+		offset = gma & (I915_GTT_PAGE_SIZE - 1);
+		len = min(end_gma - gma, I915_GTT_PAGE_SIZE - offset);
+
+		intel_gvt_read_gpa(vgpu, gpa, buf, len);
+		if (memcmp(buf, data, len)) {
+			match = false;
+			break;
+		}
+
+		data += len;
+		gma += len;
+	}
+
+	kfree(buf);
+	return match;
+}
+
+static struct intel_vgpu_bb_cache_entry *
+bb_cache_lookup(struct parser_exec_state *s, struct intel_vgpu_mm *mm,
+		unsigned long gma)
+{
+	struct intel_vgpu_submission *submission = &s->vgpu->submission;
+	struct list_head *entries = &submission->bb_cache[s->engine->id].entries;
+	bool ppgtt = s->buf_addr_type != GTT_BUFFER;
+	struct intel_vgpu_bb_cache_entry *e;
+
+	list_for_each_entry(e, entries, link) {
+		if (e->gma != gma || e->ppgtt != ppgtt)
+			continue;
+
+		if (!bb_cache_match(s->vgpu, mm, e)) {
+			bb_cache_free(submission, s->engine->id, e);
+			return NULL;
+		}
+
+		list_move(&e->link, entries);
+		return e;
+	}
+
+	return NULL;
+}
+
+static void bb_cache_insert(struct parser_exec_state *s,
+			    const struct bb_scan *scan)
+{
+	struct intel_vgpu_submission *submission = &s->vgpu->submission;
+	int ring_id = s->engine->id;
+	struct list_head *entries = &submission->bb_cache[ring_id].entries;
+	struct intel_vgpu_bb_cache_entry *e, *n;
+
+	if (scan->size > GVT_BB_CACHE_MAX_SIZE)
+		return;
+
+	list_for_each_entry_safe(e, n, entries, link) {
+		if (e->gma == scan->gma && e->ppgtt == scan->ppgtt)
+			bb_cache_free(submission, ring_id, e);
+	}
+
+	if (submission->bb_cache[ring_id].count == GVT_BB_CACHE_ENTRIES)
+		bb_cache_free(submission, ring_id,
+			      list_last_entry(entries, typeof(*e), link));
+
+	e = kvmalloc(struct_size(e, data, scan->size), GFP_KERNEL);
+	if (!e)
+		return;
+
+	e->gma = scan->gma;
+	e->size = scan->size;
+	e->end_offset = scan->end_offset;
+	e->ppgtt = scan->ppgtt;
+	memcpy(e->data, scan->va, scan->size);
+
+	list_add(&e->link, entries);
+	submission->bb_cache[ring_id].count++;
+}
+
+/**
+ * intel_gvt_clean_bb_cache - drop the cached batch buffers of a vGPU
+ * @vgpu: a vGPU
+ * @engine_mask: engines whose cache is dropped
+ */
+void intel_gvt_clean_bb_cache(struct intel_vgpu *vgpu,
+			      intel_engine_mask_t engine_mask)
+{
+	struct intel_vgpu_submission *s = &vgpu->submission;
+	struct intel_vgpu_bb_cache_entry *e, *n;
+	struct intel_engine_cs *engine;
+	intel_engine_mask_t tmp;
+
+	for_each_engine_masked(engine, vgpu->gvt->gt, engine_mask, tmp) {
+		list_for_each_entry_safe(e, n, &s->bb_cache[engine->id].entries,
+					 link)
+			bb_cache_free(s, engine->id, e);
+	}
+}
 
 /*
  * Check whether a batch buffer needs to be scanned. Currently
@@ -1903,7 +2105,9 @@ static int audit_bb_end(struct parser_exec_state *s, void *va)
 static int perform_bb_shadow(struct parser_exec_state *s)
 {
 	struct intel_vgpu *vgpu = s->vgpu;
+	struct intel_vgpu_bb_cache_entry *cached;
 	struct intel_vgpu_shadow_bb *bb;
+	struct bb_scan *scan;
 	unsigned long gma = 0;
 	unsigned long bb_size;
 	unsigned long bb_end_cmd_offset;
@@ -1917,9 +2121,15 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 	if (gma == INTEL_GVT_INVALID_ADDR)
 		return -EFAULT;
 
-	ret = find_bb_size(s, &bb_size, &bb_end_cmd_offset);
-	if (ret)
-		return ret;
+	cached = bb_cache_lookup(s, mm, gma);
+	if (cached) {
+		bb_size = cached->size;
+		bb_end_cmd_offset = cached->end_offset;
+	} else {
+		ret = find_bb_size(s, &bb_size, &bb_end_cmd_offset);
+		if (ret)
+			return ret;
+	}
 
 	bb = kzalloc_obj(*bb);
 	if (!bb)
@@ -1956,18 +2166,22 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 		goto err_free_obj;
 	}
 
-	ret = copy_gma_to_hva(s->vgpu, mm,
-			      gma, gma + bb_size,
-			      bb->va + start_offset);
-	if (ret < 0) {
-		gvt_vgpu_err("fail to copy guest ring buffer\n");
-		ret = -EFAULT;
-		goto err_unmap;
-	}
+	if (cached) {
+		memcpy(bb->va + start_offset, cached->data, bb_size);
+	} else {
+		ret = copy_gma_to_hva(s->vgpu, mm,
+				      gma, gma + bb_size,
+				      bb->va + start_offset);
+		if (ret < 0) {
+			gvt_vgpu_err("fail to copy guest ring buffer\n");
+			ret = -EFAULT;
+			goto err_unmap;
+		}
 
-	ret = audit_bb_end(s, bb->va + start_offset + bb_end_cmd_offset);
-	if (ret)
-		goto err_unmap;
+		ret = audit_bb_end(s, bb->va + start_offset + bb_end_cmd_offset);
+		if (ret)
+			goto err_unmap;
+	}
 
 	i915_gem_object_unlock(bb->obj);
 	INIT_LIST_HEAD(&bb->list);
@@ -1990,6 +2204,22 @@ static int perform_bb_shadow(struct parser_exec_state *s)
 	 */
 	s->ip_va = bb->va + start_offset;
 	s->ip_gma = gma;
+
+	scan = bb_scan(s);
+	if (cached) {
+		/* Already audited, resume at its MI_BATCH_BUFFER_END */
+		scan->va = NULL;
+		s->ip_va += bb_end_cmd_offset;
+		s->ip_gma += bb_end_cmd_offset;
+	} else {
+		scan->va = s->ip_va;
+		scan->gma = gma;
+		scan->size = bb_size;
+		scan->end_offset = bb_end_cmd_offset;
+		scan->ppgtt = bb->ppgtt;
+		scan->tainted = false;
+	}
+
 	return 0;
 err_unmap:
 	i915_gem_object_unpin_map(bb->obj);
@@ -2011,6 +2241,9 @@ static int cmd_handler_mi_batch_buffer_start(struct parser_exec_state *s)
 		return -EFAULT;
 	}
 
+	/* A batch buffer calling or chaining to another isn't cached */
+	bb_cache_taint(s);
+
 	second_level = BATCH_BUFFER_2ND_LEVEL_BIT(cmd_val(s, 0)) == 1;
 	if (second_level && (s->buf_type != BATCH_BUFFER_INSTRUCTION)) {
 		gvt_vgpu_err("Jumping to 2nd level BB from RB is not allowed\n");
@@ -2865,6 +3098,7 @@ static int scan_workload(struct intel_vgpu_workload *workload)
 	s.ring_tail = gma_tail;
 	s.rb_va = workload->shadow_ring_buffer_va;
 	s.workload = workload;
+	memset(s.bb_scan, 0, sizeof(s.bb_scan));
 	s.is_ctx_wa = false;
 
 	if (bypass_scan_mask & workload->engine->mask || gma_head == gma_tail)
@@ -2912,6 +3146,7 @@ static int scan_wa_ctx(struct intel_shadow_wa_ctx *wa_ctx)
 	s.ring_tail = gma_tail;
 	s.rb_va = wa_ctx->indirect_ctx.shadow_va;
 	s.workload = workload;
+	memset(s.bb_scan, 0, sizeof(s.bb_scan));
 	s.is_ctx_wa = true;
 
 	ret = ip_gma_set(&s, gma_head);
@@ -3144,6 +3379,7 @@ void intel_gvt_update_reg_whitelist(struct intel_vgpu *vgpu)
 		s.ring_tail = s.ring_size;
 		s.rb_va = vaddr + start;
 		s.workload = NULL;
+		memset(s.bb_scan, 0, sizeof(s.bb_scan));
 		s.is_ctx_wa = false;
 		s.is_init_ctx = true;
 
@@ -3196,6 +3432,7 @@ int intel_gvt_scan_engine_context(struct intel_vgpu_workload *workload)
 	s.ring_tail = gma_start + gma_tail;
 	s.rb_va = ce->lrc_reg_state;
 	s.workload = workload;
+	memset(s.bb_scan, 0, sizeof(s.bb_scan));
 	s.is_ctx_wa = false;
 	s.is_init_ctx = false;
 
@@ -36,6 +36,8 @@
 #ifndef _GVT_CMD_PARSER_H_
 #define _GVT_CMD_PARSER_H_
 
+#include "gt/intel_engine_types.h"
+
 #define GVT_CMD_HASH_BITS 7
 
 struct intel_gvt;
@@ -55,4 +57,7 @@ void intel_gvt_update_reg_whitelist(struct intel_vgpu *vgpu);
 
 int intel_gvt_scan_engine_context(struct intel_vgpu_workload *workload);
 
+void intel_gvt_clean_bb_cache(struct intel_vgpu *vgpu,
+			      intel_engine_mask_t engine_mask);
+
 #endif
@@ -26,6 +26,7 @@
 
 #include "gvt.h"
 #include "i915_drv.h"
+#include "sched_policy.h"
 
 struct mmio_diff_param {
 	struct intel_vgpu *vgpu;
@@ -170,6 +171,146 @@ static int vgpu_status_get(void *data, u64 *val)
 
 DEFINE_DEBUGFS_ATTRIBUTE(vgpu_status_fops, vgpu_status_get, NULL, "0x%llx\n");
 
+/* Show the registers on the MMIO fast path and their hit counts. */
+static int vgpu_mmio_hot_show(struct seq_file *s, void *unused)
+{
+	struct intel_vgpu *vgpu = s->private;
+	int i;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	seq_printf(s, "%-8s %s\n", "Offset", "Hits");
+	for (i = 0; i < ARRAY_SIZE(vgpu->mmio.fast); i++) {
+		if (!vgpu->mmio.fast[i].info)
+			continue;
+		seq_printf(s, "%08x %llu\n", vgpu->mmio.fast[i].offset,
+			   vgpu->mmio.fast[i].hits);
+	}
+	mutex_unlock(&vgpu->vgpu_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_mmio_hot);
+
+static int vgpu_mmio_hot_add_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+	int ret;
+
+	if (val > U32_MAX)
+		return -EINVAL;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	ret = intel_vgpu_mmio_fast_add(vgpu, val);
+	mutex_unlock(&vgpu->vgpu_lock);
+	return ret;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(vgpu_mmio_hot_add_fops,
+			 NULL, vgpu_mmio_hot_add_set, "0x%llx\n");
+
+/* Show the per register trap counts collected while profiling. */
+static int vgpu_mmio_trap_show(struct seq_file *s, void *unused)
+{
+	struct intel_vgpu *vgpu = s->private;
+	struct intel_vgpu_mmio_trap *t;
+	int bkt;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	seq_printf(s, "%-8s %-12s %-12s\n", "Offset", "Reads", "Writes");
+	hash_for_each(vgpu->mmio.trap_table, bkt, t, node)
+		seq_printf(s, "%08x %-12llu %-12llu\n",
+			   t->offset, t->reads, t->writes);
+	seq_printf(s, "Not profiled: %llu\n", vgpu->mmio.trap_untracked);
+	mutex_unlock(&vgpu->vgpu_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_mmio_trap);
+
+static int vgpu_mmio_profile_get(void *data, u64 *val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	*val = vgpu->mmio.profile;
+	return 0;
+}
+
+static int vgpu_mmio_profile_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	intel_vgpu_mmio_set_profile(vgpu, !!val);
+	return 0;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(vgpu_mmio_profile_fops,
+			 vgpu_mmio_profile_get, vgpu_mmio_profile_set,
+			 "%llu\n");
+
+static int vgpu_sched_show(struct seq_file *s, void *unused)
+{
+	intel_vgpu_sched_show(s->private, s);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_sched);
+
+static int vgpu_sched_cap_get(void *data, u64 *val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	*val = vgpu->sched_ctl.cap;
+	return 0;
+}
+
+static int vgpu_sched_cap_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	if (val > 100)
+		return -EINVAL;
+
+	return intel_vgpu_set_sched_ctl(vgpu, val, vgpu->sched_ctl.reserve);
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(vgpu_sched_cap_fops,
+			 vgpu_sched_cap_get, vgpu_sched_cap_set, "%llu\n");
+
+static int vgpu_sched_reserve_get(void *data, u64 *val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	*val = vgpu->sched_ctl.reserve;
+	return 0;
+}
+
+static int vgpu_sched_reserve_set(void *data, u64 val)
+{
+	struct intel_vgpu *vgpu = (struct intel_vgpu *)data;
+
+	if (val > 100)
+		return -EINVAL;
+
+	return intel_vgpu_set_sched_ctl(vgpu, vgpu->sched_ctl.cap, val);
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(vgpu_sched_reserve_fops,
+			 vgpu_sched_reserve_get, vgpu_sched_reserve_set,
+			 "%llu\n");
+
+/* Show the shadow PPGTT write-protection and out-of-sync statistics. */
+static int vgpu_ppgtt_oos_show(struct seq_file *s, void *unused)
+{
+	struct intel_vgpu *vgpu = s->private;
+	struct intel_vgpu_gtt *gtt = &vgpu->gtt;
+
+	mutex_lock(&vgpu->vgpu_lock);
+	seq_printf(s, "wp traps: %llu\n", gtt->stats.wp_traps);
+	seq_printf(s, "oos attach: %llu\n", gtt->stats.oos_attach);
+	seq_printf(s, "oos resync: %llu\n", gtt->stats.oos_resync);
+	seq_printf(s, "oos resync pages: %llu\n", gtt->stats.oos_resync_pages);
+	mutex_unlock(&vgpu->vgpu_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vgpu_ppgtt_oos);
+
 /**
  * intel_gvt_debugfs_add_vgpu - register debugfs entries for a vGPU
  * @vgpu: a vGPU
@@ -187,6 +328,22 @@ void intel_gvt_debugfs_add_vgpu(struct intel_vgpu *vgpu)
 				   &vgpu_scan_nonprivbb_fops);
 	debugfs_create_file_unsafe("status", 0644, vgpu->debugfs, vgpu,
 				   &vgpu_status_fops);
+	debugfs_create_file("ppgtt_oos", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_ppgtt_oos_fops);
+	debugfs_create_file("sched", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_sched_fops);
+	debugfs_create_file("mmio_hot", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_mmio_hot_fops);
+	debugfs_create_file_unsafe("mmio_hot_add", 0200, vgpu->debugfs, vgpu,
+				   &vgpu_mmio_hot_add_fops);
+	debugfs_create_file("mmio_trap", 0444, vgpu->debugfs, vgpu,
+			    &vgpu_mmio_trap_fops);
+	debugfs_create_file_unsafe("mmio_profile", 0644, vgpu->debugfs, vgpu,
+				   &vgpu_mmio_profile_fops);
+	debugfs_create_file_unsafe("sched_cap", 0644, vgpu->debugfs, vgpu,
+				   &vgpu_sched_cap_fops);
+	debugfs_create_file_unsafe("sched_reserve", 0644, vgpu->debugfs, vgpu,
+				   &vgpu_sched_reserve_fops);
 }
 
 /**
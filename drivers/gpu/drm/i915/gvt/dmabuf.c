@@ -44,6 +44,9 @@
 
 #define GEN8_DECODE_PTE(pte) (pte & GENMASK_ULL(63, 12))
 
+/* Max number of exported dma-bufs kept around per vGPU */
+#define GVT_DMABUF_CACHE_SIZE 4
+
 static int vgpu_gem_get_pages(struct drm_i915_gem_object *obj)
 {
 	struct drm_i915_private *dev_priv = to_i915(obj->base.dev);
@@ -497,6 +500,28 @@ out:
 	return (ret == -ENODEV) ? 0 : ret;
 }
 
+/*
+ * Drop the cached export of the least recently used dmabuf_obj once the
+ * cache is over its size. The last dma_buf_put() only defers the release
+ * through fput(), so it is fine to call with dmabuf_lock held.
+ */
+static void dmabuf_cache_evict(struct intel_vgpu *vgpu)
+{
+	struct intel_vgpu_dmabuf_obj *dmabuf_obj, *lru = NULL;
+	unsigned int count = 0;
+
+	list_for_each_entry(dmabuf_obj, &vgpu->dmabuf_obj_list_head, list) {
+		if (!dmabuf_obj->dmabuf)
+			continue;
+		if (!lru)
+			lru = dmabuf_obj;
+		count++;
+	}
+
+	if (count > GVT_DMABUF_CACHE_SIZE)
+		dma_buf_put(fetch_and_zero(&lru->dmabuf));
+}
+
 /* To associate an exposed dmabuf with the dmabuf_obj */
 int intel_vgpu_get_dmabuf(struct intel_vgpu *vgpu, unsigned int dmabuf_id)
 {
@@ -516,6 +541,35 @@ int intel_vgpu_get_dmabuf(struct intel_vgpu *vgpu, unsigned int dmabuf_id)
 		goto out;
 	}
 
+	/*
+	 * The plane didn't change since it was exported, give out another
+	 * fd of the same dma-buf instead of building a new GEM object.
+	 */
+	if (dmabuf_obj->dmabuf) {
+		dmabuf = dmabuf_obj->dmabuf;
+		get_dma_buf(dmabuf);
+
+		ret = dma_buf_fd(dmabuf, DRM_CLOEXEC | DRM_RDWR);
+		if (ret < 0) {
+			gvt_vgpu_err("create dma-buf fd failed ret:%d\n", ret);
+			dma_buf_put(dmabuf);
+			goto out;
+		}
+		dmabuf_fd = ret;
+
+		if (dmabuf_obj->initref) {
+			dmabuf_obj->initref = false;
+			dmabuf_obj_put(dmabuf_obj);
+		}
+
+		list_move_tail(&dmabuf_obj->list, &vgpu->dmabuf_obj_list_head);
+		mutex_unlock(&vgpu->dmabuf_lock);
+
+		gvt_dbg_dpy("vgpu%d: dmabuf:%d, reuse cached dma-buf, fd:%d\n",
+			    vgpu->id, dmabuf_obj->dmabuf_id, dmabuf_fd);
+		return dmabuf_fd;
+	}
+
 	obj = vgpu_create_gem(dev, dmabuf_obj->info);
 	if (obj == NULL) {
 		gvt_vgpu_err("create gvt gem obj failed\n");
@@ -546,6 +600,11 @@ int intel_vgpu_get_dmabuf(struct intel_vgpu *vgpu, unsigned int dmabuf_id)
 		dmabuf_obj_put(dmabuf_obj);
 	}
 
+	get_dma_buf(dmabuf);
+	dmabuf_obj->dmabuf = dmabuf;
+	list_move_tail(&dmabuf_obj->list, &vgpu->dmabuf_obj_list_head);
+	dmabuf_cache_evict(vgpu);
+
 	mutex_unlock(&vgpu->dmabuf_lock);
 
 	gvt_dbg_dpy("vgpu%d: dmabuf:%d, dmabuf ref %d, fd:%d\n"
@@ -582,6 +641,9 @@ void intel_vgpu_dmabuf_cleanup(struct intel_vgpu *vgpu)
 		idr_remove(&vgpu->object_idr, dmabuf_obj->dmabuf_id);
 		list_del(pos);
 
+		if (dmabuf_obj->dmabuf)
+			dma_buf_put(fetch_and_zero(&dmabuf_obj->dmabuf));
+
 		/* dmabuf_obj might be freed in dmabuf_obj_put */
 		if (dmabuf_obj->initref) {
 			dmabuf_obj->initref = false;
@@ -591,3 +653,30 @@ void intel_vgpu_dmabuf_cleanup(struct intel_vgpu *vgpu)
 	}
 	mutex_unlock(&vgpu->dmabuf_lock);
 }
+
+/**
+ * intel_vgpu_dmabuf_invalidate - drop the cached exports of a GGTT range
+ * @vgpu: a vGPU
+ * @start: first graphics memory address whose GGTT entry was rewritten
+ * @end: end of the rewritten range, exclusive
+ *
+ * The pages of a cached export are resolved from the GGTT entries covering
+ * its plane, which the cache key only partially checks. Once any of those
+ * entries is rewritten, drop the export so that the next get_dmabuf builds
+ * a new one from the current entries.
+ */
+void intel_vgpu_dmabuf_invalidate(struct intel_vgpu *vgpu, u64 start, u64 end)
+{
+	struct intel_vgpu_dmabuf_obj *dmabuf_obj;
+
+	mutex_lock(&vgpu->dmabuf_lock);
+	list_for_each_entry(dmabuf_obj, &vgpu->dmabuf_obj_list_head, list) {
+		struct intel_vgpu_fb_info *fb_info = dmabuf_obj->info;
+
+		if (dmabuf_obj->dmabuf &&
+		    fb_info->start < end &&
+		    start < fb_info->start + fb_info->size)
+			dma_buf_put(fetch_and_zero(&dmabuf_obj->dmabuf));
+	}
+	mutex_unlock(&vgpu->dmabuf_lock);
+}
@@ -34,6 +34,7 @@
 #include <linux/kref.h>
 #include <linux/types.h>
 
+struct dma_buf;
 struct intel_vgpu;
 struct intel_vgpu_dmabuf_obj;
 
@@ -62,11 +63,14 @@ struct intel_vgpu_dmabuf_obj {
 	__u32 dmabuf_id;
 	struct kref kref;
 	bool initref;
+	/* cached export, handed out again while the plane is unchanged */
+	struct dma_buf *dmabuf;
 	struct list_head list;
 };
 
 int intel_vgpu_query_plane(struct intel_vgpu *vgpu, void *args);
 int intel_vgpu_get_dmabuf(struct intel_vgpu *vgpu, unsigned int dmabuf_id);
 void intel_vgpu_dmabuf_cleanup(struct intel_vgpu *vgpu);
+void intel_vgpu_dmabuf_invalidate(struct intel_vgpu *vgpu, u64 start, u64 end);
 
 #endif
@@ -531,6 +531,8 @@ static void clean_execlist(struct intel_vgpu *vgpu,
 		s->ring_scan_buffer[engine->id] = NULL;
 		s->ring_scan_buffer_size[engine->id] = 0;
 	}
+
+	intel_gvt_clean_bb_cache(vgpu, engine_mask);
 }
 
 static void reset_execlist(struct intel_vgpu *vgpu,
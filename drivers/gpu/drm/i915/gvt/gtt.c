@@ -51,7 +51,17 @@
 #endif
 
 static bool enable_out_of_sync = false;
-static int preallocated_oos_pages = 8192;
+static int preallocated_oos_pages = 512;
+static int max_oos_pages = 8192;
+
+/*
+ * A guest page table page is switched to out-of-sync once it has taken
+ * oos_write_threshold trapped writes with no more than oos_write_window_ms
+ * between two consecutive ones, i.e. while the guest is rewriting it in a
+ * burst. Pages that are only touched occasionally stay write-protected.
+ */
+static unsigned int oos_write_threshold = 2;
+static unsigned int oos_write_window_ms = 100;
 
 /*
  * validate a gm address and related range size,
@@ -730,6 +740,8 @@ static int ppgtt_write_protection_handler(
 	if (bytes != 4 && bytes != 8)
 		return -EINVAL;
 
+	spt->vgpu->gtt.stats.wp_traps++;
+
 	ret = ppgtt_handle_guest_write_page_table_bytes(spt, gpa, data, bytes);
 	if (ret)
 		return ret;
@@ -1393,8 +1405,20 @@ static int detach_oos_page(struct intel_vgpu *vgpu,
 	spt->guest_page.oos_page = NULL;
 	oos_page->spt = NULL;
 
+	spin_lock(&gvt->gtt.oos_page_lock);
 	list_del_init(&oos_page->vm_list);
+	/* Shrink the pool back to its preallocated size as pages retire. */
+	if (gvt->gtt.oos_page_count > preallocated_oos_pages) {
+		list_del(&oos_page->list);
+		gvt->gtt.oos_page_count--;
+		spin_unlock(&gvt->gtt.oos_page_lock);
+
+		free_page((unsigned long)oos_page->mem);
+		kfree(oos_page);
+		return 0;
+	}
 	list_move_tail(&oos_page->list, &gvt->gtt.oos_page_free_list_head);
+	spin_unlock(&gvt->gtt.oos_page_lock);
 
 	return 0;
 }
@@ -1414,7 +1438,9 @@ static int attach_oos_page(struct intel_vgpu_oos_page *oos_page,
 	oos_page->spt = spt;
 	spt->guest_page.oos_page = oos_page;
 
-	list_move_tail(&oos_page->list, &gvt->gtt.oos_page_use_list_head);
+	spin_lock(&gvt->gtt.oos_page_lock);
+	list_move_tail(&oos_page->list, &spt->vgpu->gtt.oos_page_use_list_head);
+	spin_unlock(&gvt->gtt.oos_page_lock);
 
 	trace_oos_change(spt->vgpu->id, "attach", oos_page->id,
 			 spt, spt->guest_page.type);
@@ -1433,32 +1459,111 @@ static int ppgtt_set_guest_page_sync(struct intel_vgpu_ppgtt_spt *spt)
 	trace_oos_change(spt->vgpu->id, "set page sync", oos_page->id,
 			 spt, spt->guest_page.type);
 
+	spin_lock(&spt->vgpu->gvt->gtt.oos_page_lock);
 	list_del_init(&oos_page->vm_list);
+	spin_unlock(&spt->vgpu->gvt->gtt.oos_page_lock);
 	return sync_oos_page(spt->vgpu, oos_page);
 }
 
-static int ppgtt_allocate_oos_page(struct intel_vgpu_ppgtt_spt *spt)
+static struct intel_vgpu_oos_page *alloc_oos_page(void)
+{
+	struct intel_vgpu_oos_page *oos_page;
+
+	oos_page = kzalloc_obj(*oos_page);
+	if (!oos_page)
+		return NULL;
+
+	oos_page->mem = (void *)__get_free_pages(GFP_KERNEL, 0);
+	if (!oos_page->mem) {
+		kfree(oos_page);
+		return NULL;
+	}
+
+	INIT_LIST_HEAD(&oos_page->list);
+	INIT_LIST_HEAD(&oos_page->vm_list);
+	return oos_page;
+}
+
+/*
+ * Take an oos page off the free list, or grow the pool up to max_oos_pages
+ * if the free list is empty. Returns NULL when the pool is exhausted.
+ */
+static struct intel_vgpu_oos_page *get_free_oos_page(struct intel_gvt *gvt)
 {
-	struct intel_gvt *gvt = spt->vgpu->gvt;
 	struct intel_gvt_gtt *gtt = &gvt->gtt;
+	struct intel_vgpu_oos_page *oos_page;
+
+	spin_lock(&gtt->oos_page_lock);
+	oos_page = list_first_entry_or_null(&gtt->oos_page_free_list_head,
+					    struct intel_vgpu_oos_page, list);
+	if (oos_page)
+		list_del_init(&oos_page->list);
+	if (oos_page || gtt->oos_page_count >= max_oos_pages) {
+		spin_unlock(&gtt->oos_page_lock);
+		return oos_page;
+	}
+	/* Reserve the slot so that concurrent vGPUs can't overshoot. */
+	gtt->oos_page_count++;
+	spin_unlock(&gtt->oos_page_lock);
+
+	oos_page = alloc_oos_page();
+
+	spin_lock(&gtt->oos_page_lock);
+	if (oos_page)
+		oos_page->id = gtt->oos_page_next_id++;
+	else
+		gtt->oos_page_count--;
+	spin_unlock(&gtt->oos_page_lock);
+
+	return oos_page;
+}
+
+static void put_free_oos_page(struct intel_gvt *gvt,
+			      struct intel_vgpu_oos_page *oos_page)
+{
+	spin_lock(&gvt->gtt.oos_page_lock);
+	list_add_tail(&oos_page->list, &gvt->gtt.oos_page_free_list_head);
+	spin_unlock(&gvt->gtt.oos_page_lock);
+}
+
+static int ppgtt_allocate_oos_page(struct intel_vgpu_ppgtt_spt *spt)
+{
+	struct intel_vgpu *vgpu = spt->vgpu;
 	struct intel_vgpu_oos_page *oos_page = spt->guest_page.oos_page;
 	int ret;
 
 	WARN(oos_page, "shadow PPGTT page has already has a oos page\n");
 
-	if (list_empty(&gtt->oos_page_free_list_head)) {
-		oos_page = container_of(gtt->oos_page_use_list_head.next,
-			struct intel_vgpu_oos_page, list);
-		ret = ppgtt_set_guest_page_sync(oos_page->spt);
-		if (ret)
-			return ret;
-		ret = detach_oos_page(spt->vgpu, oos_page);
+	oos_page = get_free_oos_page(vgpu->gvt);
+	if (!oos_page) {
+		/*
+		 * Pool exhausted, recycle the least recently attached page
+		 * of this vGPU. Pages of other vGPUs are left alone as their
+		 * vgpu_lock is not held here.
+		 */
+		if (list_empty(&vgpu->gtt.oos_page_use_list_head))
+			return -ENOSPC;
+
+		oos_page = list_first_entry(&vgpu->gtt.oos_page_use_list_head,
+					    struct intel_vgpu_oos_page, list);
+		if (!list_empty(&oos_page->vm_list)) {
+			ret = ppgtt_set_guest_page_sync(oos_page->spt);
+			if (ret)
+				return ret;
+		}
+		ret = detach_oos_page(vgpu, oos_page);
 		if (ret)
 			return ret;
-	} else
-		oos_page = container_of(gtt->oos_page_free_list_head.next,
-			struct intel_vgpu_oos_page, list);
-	return attach_oos_page(oos_page, spt);
+
+		oos_page = get_free_oos_page(vgpu->gvt);
+		if (!oos_page)
+			return -ENOSPC;
+	}
+
+	ret = attach_oos_page(oos_page, spt);
+	if (ret)
+		put_free_oos_page(vgpu->gvt, oos_page);
+	return ret;
 }
 
 static int ppgtt_set_guest_page_oos(struct intel_vgpu_ppgtt_spt *spt)
@@ -1471,7 +1576,11 @@ static int ppgtt_set_guest_page_oos(struct intel_vgpu_ppgtt_spt *spt)
 	trace_oos_change(spt->vgpu->id, "set page out of sync", oos_page->id,
 			 spt, spt->guest_page.type);
 
+	spt->vgpu->gtt.stats.oos_attach++;
+
+	spin_lock(&spt->vgpu->gvt->gtt.oos_page_lock);
 	list_add_tail(&oos_page->vm_list, &spt->vgpu->gtt.oos_page_list_head);
+	spin_unlock(&spt->vgpu->gvt->gtt.oos_page_lock);
 	return intel_vgpu_disable_page_track(spt->vgpu, spt->guest_page.gfn);
 }
 
@@ -1480,7 +1589,9 @@ static int ppgtt_set_guest_page_oos(struct intel_vgpu_ppgtt_spt *spt)
  * @vgpu: a vGPU
  *
  * This function is called before submitting a guest workload to host,
- * to sync all the out-of-synced shadow for vGPU
+ * to sync all the out-of-synced shadow for vGPU. All the guest page table
+ * writes that happened since the last submission are thus shadowed in one
+ * batch instead of one trap per entry.
  *
  * Returns:
  * Zero on success, negative error code if failed.
@@ -1494,12 +1605,18 @@ int intel_vgpu_sync_oos_pages(struct intel_vgpu *vgpu)
 	if (!enable_out_of_sync)
 		return 0;
 
+	if (list_empty(&vgpu->gtt.oos_page_list_head))
+		return 0;
+
+	vgpu->gtt.stats.oos_resync++;
+
 	list_for_each_safe(pos, n, &vgpu->gtt.oos_page_list_head) {
 		oos_page = container_of(pos,
 				struct intel_vgpu_oos_page, vm_list);
 		ret = ppgtt_set_guest_page_sync(oos_page->spt);
 		if (ret)
 			return ret;
+		vgpu->gtt.stats.oos_resync_pages++;
 	}
 	return 0;
 }
@@ -1574,7 +1691,7 @@ static inline bool can_do_out_of_sync(struct intel_vgpu_ppgtt_spt *spt)
 {
 	return enable_out_of_sync
 		&& gtt_type_is_pte_pt(spt->guest_page.type)
-		&& spt->guest_page.write_cnt >= 2;
+		&& spt->guest_page.write_cnt >= oos_write_threshold;
 }
 
 static void ppgtt_set_post_shadow(struct intel_vgpu_ppgtt_spt *spt,
@@ -1673,6 +1790,11 @@ static int ppgtt_handle_guest_write_page_table_bytes(
 	if (!enable_out_of_sync)
 		return 0;
 
+	/* A page that went quiet has to get hot again before going oos. */
+	if (time_after(jiffies, spt->guest_page.write_jiffies +
+		       msecs_to_jiffies(oos_write_window_ms)))
+		spt->guest_page.write_cnt = 0;
+	spt->guest_page.write_jiffies = jiffies;
 	spt->guest_page.write_cnt++;
 
 	if (spt->guest_page.oos_page)
@@ -1680,8 +1802,14 @@ static int ppgtt_handle_guest_write_page_table_bytes(
 				false, 0, vgpu);
 
 	if (can_do_out_of_sync(spt)) {
-		if (!spt->guest_page.oos_page)
-			ppgtt_allocate_oos_page(spt);
+		if (!spt->guest_page.oos_page) {
+			ret = ppgtt_allocate_oos_page(spt);
+			/* No oos page available, keep trapping the writes. */
+			if (ret == -ENOSPC)
+				return 0;
+			if (ret)
+				return ret;
+		}
 
 		ret = ppgtt_set_guest_page_oos(spt);
 		if (ret < 0)
@@ -2245,6 +2373,8 @@ static int emulate_ggtt_mmio_write(struct intel_vgpu *vgpu, unsigned int off,
 
 	ggtt_set_host_entry(ggtt_mm, &m, g_gtt_index);
 	ggtt_invalidate(gvt->gt);
+
+	intel_vgpu_dmabuf_invalidate(vgpu, gma, gma + I915_GTT_PAGE_SIZE);
 	return 0;
 }
 
@@ -2408,6 +2538,7 @@ int intel_vgpu_init_gtt(struct intel_vgpu *vgpu)
 
 	INIT_LIST_HEAD(&gtt->ppgtt_mm_list_head);
 	INIT_LIST_HEAD(&gtt->oos_page_list_head);
+	INIT_LIST_HEAD(&gtt->oos_page_use_list_head);
 	INIT_LIST_HEAD(&gtt->post_shadow_list_head);
 
 	gtt->ggtt_mm = intel_vgpu_create_ggtt_mm(vgpu);
@@ -2480,15 +2611,15 @@ static void clean_spt_oos(struct intel_gvt *gvt)
 	struct list_head *pos, *n;
 	struct intel_vgpu_oos_page *oos_page;
 
-	WARN(!list_empty(&gtt->oos_page_use_list_head),
-		"someone is still using oos page\n");
-
 	list_for_each_safe(pos, n, &gtt->oos_page_free_list_head) {
 		oos_page = container_of(pos, struct intel_vgpu_oos_page, list);
 		list_del(&oos_page->list);
+		gtt->oos_page_count--;
 		free_page((unsigned long)oos_page->mem);
 		kfree(oos_page);
 	}
+
+	WARN(gtt->oos_page_count, "someone is still using oos page\n");
 }
 
 static int setup_spt_oos(struct intel_gvt *gvt)
@@ -2498,25 +2629,21 @@ static int setup_spt_oos(struct intel_gvt *gvt)
 	int i;
 	int ret;
 
+	spin_lock_init(&gtt->oos_page_lock);
 	INIT_LIST_HEAD(&gtt->oos_page_free_list_head);
-	INIT_LIST_HEAD(&gtt->oos_page_use_list_head);
+	gtt->oos_page_count = 0;
+	gtt->oos_page_next_id = 0;
 
+	/* The pool grows on demand up to max_oos_pages from here. */
 	for (i = 0; i < preallocated_oos_pages; i++) {
-		oos_page = kzalloc_obj(*oos_page);
+		oos_page = alloc_oos_page();
 		if (!oos_page) {
 			ret = -ENOMEM;
 			goto fail;
 		}
-		oos_page->mem = (void *)__get_free_pages(GFP_KERNEL, 0);
-		if (!oos_page->mem) {
-			ret = -ENOMEM;
-			kfree(oos_page);
-			goto fail;
-		}
 
-		INIT_LIST_HEAD(&oos_page->list);
-		INIT_LIST_HEAD(&oos_page->vm_list);
-		oos_page->id = i;
+		oos_page->id = gtt->oos_page_next_id++;
+		gtt->oos_page_count++;
 		list_add_tail(&oos_page->list, &gtt->oos_page_free_list_head);
 	}
 
@@ -2755,6 +2882,8 @@ void intel_vgpu_reset_ggtt(struct intel_vgpu *vgpu, bool invalidate_old)
 	}
 
 	ggtt_invalidate(gvt->gt);
+
+	intel_vgpu_dmabuf_invalidate(vgpu, 0, U64_MAX);
 }
 
 /**
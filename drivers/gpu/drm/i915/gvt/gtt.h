@@ -93,8 +93,10 @@ struct intel_gvt_gtt_gma_ops {
 struct intel_gvt_gtt {
 	const struct intel_gvt_gtt_pte_ops *pte_ops;
 	const struct intel_gvt_gtt_gma_ops *gma_ops;
-	struct list_head oos_page_use_list_head;
+	spinlock_t oos_page_lock; /* protects the oos page lists and count */
 	struct list_head oos_page_free_list_head;
+	unsigned int oos_page_count;
+	unsigned int oos_page_next_id; /* ids are never reused as the pool shrinks */
 	struct mutex ppgtt_mm_lock;
 	struct list_head ppgtt_mm_lru_list_head;
 
@@ -211,8 +213,16 @@ struct intel_vgpu_gtt {
 	struct list_head ppgtt_mm_list_head;
 	struct radix_tree_root spt_tree;
 	struct list_head oos_page_list_head;
+	struct list_head oos_page_use_list_head;
 	struct list_head post_shadow_list_head;
 	struct intel_vgpu_scratch_pt scratch_pt[GTT_TYPE_MAX];
+
+	struct {
+		u64 wp_traps;
+		u64 oos_attach;
+		u64 oos_resync;
+		u64 oos_resync_pages;
+	} stats;
 };
 
 int intel_vgpu_init_gtt(struct intel_vgpu *vgpu);
@@ -255,6 +265,7 @@ struct intel_vgpu_ppgtt_spt {
 		bool pde_ips; /* for 64KB PTEs */
 		unsigned long gfn;
 		unsigned long write_cnt;
+		unsigned long write_jiffies;
 		struct intel_vgpu_oos_page *oos_page;
 	} guest_page;
 
@@ -92,8 +92,24 @@ struct intel_vgpu_fence {
 	u32 size;
 };
 
+#define GVT_MMIO_FAST_BITS 6
+
+/* A slot of the direct-mapped lookup of the hot tracked registers. */
+struct intel_vgpu_mmio_fast_entry {
+	u32 offset;
+	struct intel_gvt_mmio_info *info;
+	u64 hits;
+};
+
 struct intel_vgpu_mmio {
 	void *vreg;
+	struct intel_vgpu_mmio_fast_entry fast[BIT(GVT_MMIO_FAST_BITS)];
+
+	/* per register trap counts, only collected while profiling */
+	bool profile;
+	DECLARE_HASHTABLE(trap_table, 8);
+	unsigned int num_trap_entries;
+	u64 trap_untracked;
 };
 
 #define INTEL_GVT_MAX_BAR_NUM 4
@@ -133,6 +149,8 @@ struct intel_vgpu_display {
 
 struct vgpu_sched_ctl {
 	int weight;
+	unsigned int cap;	/* max share of GPU time in %, 0 = no cap */
+	unsigned int reserve;	/* guaranteed share of GPU time in % */
 };
 
 enum {
@@ -147,6 +165,12 @@ struct intel_vgpu_submission_ops {
 	void (*reset)(struct intel_vgpu *vgpu, intel_engine_mask_t engine_mask);
 };
 
+struct intel_vgpu_shadow_work {
+	struct work_struct work;
+	struct intel_vgpu *vgpu;
+	const struct intel_engine_cs *engine;
+};
+
 struct intel_vgpu_submission {
 	struct intel_vgpu_execlist execlist[I915_NUM_ENGINES];
 	struct list_head workload_q_head[I915_NUM_ENGINES];
@@ -161,6 +185,11 @@ struct intel_vgpu_submission {
 	DECLARE_BITMAP(tlb_handle_pending, I915_NUM_ENGINES);
 	void *ring_scan_buffer[I915_NUM_ENGINES];
 	int ring_scan_buffer_size[I915_NUM_ENGINES];
+	struct {
+		struct list_head entries;
+		unsigned int count;
+	} bb_cache[I915_NUM_ENGINES];
+	struct intel_vgpu_shadow_work shadow_work[I915_NUM_ENGINES];
 	const struct intel_vgpu_submission_ops *ops;
 	int virtual_submission_interface;
 	bool active;
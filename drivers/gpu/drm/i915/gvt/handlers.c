@@ -36,6 +36,7 @@
 
  */
 
+#include <linux/hash.h>
 #include <linux/vmalloc.h>
 
 #include <drm/display/drm_dp.h>
@@ -3130,6 +3131,94 @@ int intel_vgpu_mask_mmio_write(struct intel_vgpu *vgpu, unsigned int offset,
 	return 0;
 }
 
+static struct intel_vgpu_mmio_fast_entry *
+mmio_fast_slot(struct intel_vgpu *vgpu, unsigned int offset)
+{
+	return &vgpu->mmio.fast[hash_32(offset, GVT_MMIO_FAST_BITS)];
+}
+
+static inline struct intel_gvt_mmio_info *
+mmio_fast_lookup(struct intel_vgpu *vgpu, unsigned int offset)
+{
+	struct intel_vgpu_mmio_fast_entry *e = mmio_fast_slot(vgpu, offset);
+
+	if (!e->info || e->offset != offset)
+		return NULL;
+
+	e->hits++;
+	return e->info;
+}
+
+/**
+ * intel_vgpu_mmio_fast_add - add a register to the MMIO fast path
+ * @vgpu: a vGPU
+ * @offset: register offset
+ *
+ * The fast path is direct-mapped, so the register evicts whichever one
+ * was sitting in the same slot. Only normal tracked registers can be added,
+ * the ones covered by a special MMIO block keep going through it.
+ *
+ * Returns:
+ * Zero on success, -ENOENT if the register can't take the fast path.
+ */
+int intel_vgpu_mmio_fast_add(struct intel_vgpu *vgpu, unsigned int offset)
+{
+	struct intel_gvt *gvt = vgpu->gvt;
+	struct intel_vgpu_mmio_fast_entry *e;
+	struct intel_gvt_mmio_info *info;
+
+	if (find_mmio_block(gvt, offset))
+		return -ENOENT;
+
+	info = intel_gvt_find_mmio_info(gvt, offset);
+	if (!info)
+		return -ENOENT;
+
+	e = mmio_fast_slot(vgpu, offset);
+	e->offset = offset;
+	e->info = info;
+	e->hits = 0;
+	return 0;
+}
+
+/**
+ * intel_vgpu_init_mmio_fast - populate the MMIO fast path of a vGPU
+ * @vgpu: a vGPU
+ *
+ * Put the registers which take nearly all the guest traps, i.e. ring tail
+ * and ELSP of every engine, forcewake acks and interrupt masks, on the fast
+ * path. Registers not tracked on this platform are silently skipped.
+ */
+void intel_vgpu_init_mmio_fast(struct intel_vgpu *vgpu)
+{
+	static const i915_reg_t hot_regs[] = {
+		FORCEWAKE_ACK_HSW,
+		FORCEWAKE_ACK_RENDER_GEN9,
+		FORCEWAKE_ACK_GT_GEN9,
+		FORCEWAKE_ACK_MEDIA_GEN9,
+		GEN8_MASTER_IRQ,
+		GEN8_GT_IMR(0),
+		GEN8_GT_IMR(1),
+		GEN8_GT_IMR(2),
+		GEN8_GT_IMR(3),
+	};
+	struct intel_engine_cs *engine;
+	enum intel_engine_id id;
+	int i;
+
+	memset(vgpu->mmio.fast, 0, sizeof(vgpu->mmio.fast));
+
+	for (i = 0; i < ARRAY_SIZE(hot_regs); i++)
+		intel_vgpu_mmio_fast_add(vgpu, i915_mmio_reg_offset(hot_regs[i]));
+
+	for_each_engine(engine, vgpu->gvt->gt, id) {
+		intel_vgpu_mmio_fast_add(vgpu,
+			i915_mmio_reg_offset(RING_TAIL(engine->mmio_base)));
+		intel_vgpu_mmio_fast_add(vgpu,
+			i915_mmio_reg_offset(RING_ELSP(engine->mmio_base)));
+	}
+}
+
 /**
  * intel_vgpu_mmio_reg_rw - emulate tracked mmio registers
  * @vgpu: a vGPU
@@ -3154,6 +3243,13 @@ int intel_vgpu_mmio_reg_rw(struct intel_vgpu *vgpu, unsigned int offset,
 	if (drm_WARN_ON(&i915->drm, bytes > 8))
 		return -EINVAL;
 
+	/*
+	 * Hot registers, skip the block and hash table lookups.
+	 */
+	mmio_info = mmio_fast_lookup(vgpu, offset);
+	if (mmio_info)
+		goto tracked;
+
 	/*
 	 * Handle special MMIO blocks.
 	 */
@@ -3174,6 +3270,7 @@ int intel_vgpu_mmio_reg_rw(struct intel_vgpu *vgpu, unsigned int offset,
 		goto default_rw;
 	}
 
+tracked:
 	if (is_read)
 		return mmio_info->read(vgpu, offset, pdata, bytes);
 	else {
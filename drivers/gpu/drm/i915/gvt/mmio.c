@@ -100,6 +100,70 @@ static void failsafe_emulate_mmio_rw(struct intel_vgpu *vgpu, u64 pa,
 	mutex_unlock(&vgpu->vgpu_lock);
 }
 
+/* Bound the memory the per register trap profile can take. */
+#define GVT_MMIO_TRAP_PROFILE_MAX 1024
+
+static void mmio_trap_profile(struct intel_vgpu *vgpu, unsigned int offset,
+			      bool is_read)
+{
+	struct intel_vgpu_mmio_trap *t;
+
+	hash_for_each_possible(vgpu->mmio.trap_table, t, node, offset) {
+		if (t->offset == offset)
+			goto found;
+	}
+
+	if (vgpu->mmio.num_trap_entries >= GVT_MMIO_TRAP_PROFILE_MAX) {
+		vgpu->mmio.trap_untracked++;
+		return;
+	}
+
+	t = kzalloc_obj(*t);
+	if (!t) {
+		vgpu->mmio.trap_untracked++;
+		return;
+	}
+
+	t->offset = offset;
+	hash_add(vgpu->mmio.trap_table, &t->node, offset);
+	vgpu->mmio.num_trap_entries++;
+found:
+	if (is_read)
+		t->reads++;
+	else
+		t->writes++;
+}
+
+static void mmio_trap_profile_clear(struct intel_vgpu *vgpu)
+{
+	struct intel_vgpu_mmio_trap *t;
+	struct hlist_node *tmp;
+	int bkt;
+
+	hash_for_each_safe(vgpu->mmio.trap_table, bkt, tmp, t, node) {
+		hash_del(&t->node);
+		kfree(t);
+	}
+	vgpu->mmio.num_trap_entries = 0;
+	vgpu->mmio.trap_untracked = 0;
+}
+
+/**
+ * intel_vgpu_mmio_set_profile - turn per register trap profiling on or off
+ * @vgpu: a vGPU
+ * @enable: whether to collect the trap counts
+ *
+ * Turning the profiling on starts from empty counts.
+ */
+void intel_vgpu_mmio_set_profile(struct intel_vgpu *vgpu, bool enable)
+{
+	mutex_lock(&vgpu->vgpu_lock);
+	if (enable && !vgpu->mmio.profile)
+		mmio_trap_profile_clear(vgpu);
+	vgpu->mmio.profile = enable;
+	mutex_unlock(&vgpu->vgpu_lock);
+}
+
 /**
  * intel_vgpu_emulate_mmio_read - emulate MMIO read
  * @vgpu: a vGPU
@@ -159,6 +223,9 @@ int intel_vgpu_emulate_mmio_read(struct intel_vgpu *vgpu, u64 pa,
 			goto err;
 	}
 
+	if (unlikely(vgpu->mmio.profile))
+		mmio_trap_profile(vgpu, offset, true);
+
 	ret = intel_vgpu_mmio_reg_rw(vgpu, offset, p_data, bytes, true);
 	if (ret < 0)
 		goto err;
@@ -227,6 +294,9 @@ int intel_vgpu_emulate_mmio_write(struct intel_vgpu *vgpu, u64 pa,
 		goto out;
 	}
 
+	if (unlikely(vgpu->mmio.profile))
+		mmio_trap_profile(vgpu, offset, false);
+
 	ret = intel_vgpu_mmio_reg_rw(vgpu, offset, p_data, bytes, false);
 	if (ret < 0)
 		goto err;
@@ -323,6 +393,9 @@ int intel_vgpu_init_mmio(struct intel_vgpu *vgpu)
 	if (!vgpu->mmio.vreg)
 		return -ENOMEM;
 
+	hash_init(vgpu->mmio.trap_table);
+	intel_vgpu_init_mmio_fast(vgpu);
+
 	intel_vgpu_reset_mmio(vgpu, true);
 
 	return 0;
@@ -335,6 +408,7 @@ int intel_vgpu_init_mmio(struct intel_vgpu *vgpu)
  */
 void intel_vgpu_clean_mmio(struct intel_vgpu *vgpu)
 {
+	mmio_trap_profile_clear(vgpu);
 	vfree(vgpu->mmio.vreg);
 	vgpu->mmio.vreg = NULL;
 }
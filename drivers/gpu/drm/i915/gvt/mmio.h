@@ -67,6 +67,13 @@ struct intel_gvt_mmio_info {
 	struct hlist_node node;
 };
 
+struct intel_vgpu_mmio_trap {
+	u32 offset;
+	u64 reads;
+	u64 writes;
+	struct hlist_node node;
+};
+
 const struct intel_engine_cs *
 intel_gvt_render_mmio_to_engine(struct intel_gvt *gvt, unsigned int reg);
 unsigned long intel_gvt_get_device_type(struct intel_gvt *gvt);
@@ -99,6 +106,11 @@ int intel_vgpu_default_mmio_write(struct intel_vgpu *vgpu, unsigned int offset,
 int intel_vgpu_mmio_reg_rw(struct intel_vgpu *vgpu, unsigned int offset,
 			   void *pdata, unsigned int bytes, bool is_read);
 
+int intel_vgpu_mmio_fast_add(struct intel_vgpu *vgpu, unsigned int offset);
+void intel_vgpu_init_mmio_fast(struct intel_vgpu *vgpu);
+
+void intel_vgpu_mmio_set_profile(struct intel_vgpu *vgpu, bool enable);
+
 int intel_vgpu_mask_mmio_write(struct intel_vgpu *vgpu, unsigned int offset,
 				  void *p_data, unsigned int bytes);
 
@@ -31,6 +31,8 @@
  *
  */
 
+#include <linux/seq_file.h>
+
 #include "gvt.h"
 #include "i915_drv.h"
 #include "sched_policy.h"
@@ -51,6 +53,26 @@ static bool vgpu_has_pending_workload(struct intel_vgpu *vgpu)
 /* We give 2 seconds higher prio for vGPU during start */
 #define GVT_SCHED_VGPU_PRI_TIME  2
 
+/*
+ * Virtual runtime is the time a vGPU owned the GPU scaled by
+ * GVT_SCHED_WEIGHT_UNIT / weight, so a vGPU of weight 16 ages at wall clock
+ * speed and one of weight 4 four times faster. The busy vGPU with the
+ * lowest virtual runtime runs next.
+ */
+#define GVT_SCHED_WEIGHT_UNIT 16
+
+/*
+ * A busy vGPU is only preempted by another busy one after it has owned the
+ * GPU for this long, as every switch has to drain all the engines first.
+ */
+#define GVT_SCHED_MIN_GRANULARITY_NS (1 * NSEC_PER_MSEC)
+
+/*
+ * How much virtual runtime credit a vGPU may bank while it is idle, so a
+ * vGPU which slept for a while cannot monopolize the GPU when it wakes up.
+ */
+#define GVT_SCHED_VRUNTIME_SLACK_NS (10 * NSEC_PER_MSEC)
+
 struct vgpu_sched_data {
 	struct list_head lru_list;
 	struct intel_vgpu *vgpu;
@@ -58,9 +80,21 @@ struct vgpu_sched_data {
 	bool pri_sched;
 	ktime_t pri_time;
 	ktime_t sched_in_time;
+	ktime_t switch_in_time;
 	ktime_t sched_time;
-	ktime_t left_ts;
-	ktime_t allocated_ts;
+
+	u64 vruntime;
+	u64 engine_vruntime[I915_NUM_ENGINES];
+	ktime_t engine_busy[I915_NUM_ENGINES];
+
+	/* time used in the current balance period, for caps/reservations */
+	ktime_t period_ts;
+
+	/* time spent with pending workloads while another vGPU ran */
+	ktime_t wait_start;
+	ktime_t wait_time;
+	ktime_t max_wait_time;
+	unsigned long sched_in_count;
 
 	struct vgpu_sched_ctl sched_ctl;
 };
@@ -71,8 +105,15 @@ struct gvt_sched_data {
 	unsigned long period;
 	struct list_head lru_runq_head;
 	ktime_t expire_time;
+	u64 min_vruntime;
 };
 
+static u64 vgpu_vruntime_delta(struct vgpu_sched_data *vgpu_data, ktime_t delta)
+{
+	return div_u64(ktime_to_ns(delta) * GVT_SCHED_WEIGHT_UNIT,
+		       max(vgpu_data->sched_ctl.weight, 1));
+}
+
 static void vgpu_update_timeslice(struct intel_vgpu *vgpu, ktime_t cur_time)
 {
 	ktime_t delta_ts;
@@ -84,49 +125,42 @@ static void vgpu_update_timeslice(struct intel_vgpu *vgpu, ktime_t cur_time)
 	vgpu_data = vgpu->sched_data;
 	delta_ts = ktime_sub(cur_time, vgpu_data->sched_in_time);
 	vgpu_data->sched_time = ktime_add(vgpu_data->sched_time, delta_ts);
-	vgpu_data->left_ts = ktime_sub(vgpu_data->left_ts, delta_ts);
+	vgpu_data->period_ts = ktime_add(vgpu_data->period_ts, delta_ts);
+	vgpu_data->vruntime += vgpu_vruntime_delta(vgpu_data, delta_ts);
 	vgpu_data->sched_in_time = cur_time;
 }
 
 #define GVT_TS_BALANCE_PERIOD_MS 100
-#define GVT_TS_BALANCE_STAGE_NUM 10
+
+/* Caps and reservations are percentages of a balance period. */
+static ktime_t vgpu_period_share(unsigned int percent)
+{
+	return ktime_divns(ms_to_ktime(GVT_TS_BALANCE_PERIOD_MS), 100) * percent;
+}
+
+static bool vgpu_over_cap(struct vgpu_sched_data *vgpu_data)
+{
+	return vgpu_data->sched_ctl.cap &&
+	       vgpu_data->period_ts >= vgpu_period_share(vgpu_data->sched_ctl.cap);
+}
+
+static bool vgpu_under_reserve(struct vgpu_sched_data *vgpu_data)
+{
+	return vgpu_data->sched_ctl.reserve &&
+	       vgpu_data->period_ts < vgpu_period_share(vgpu_data->sched_ctl.reserve);
+}
 
 static void gvt_balance_timeslice(struct gvt_sched_data *sched_data)
 {
 	struct vgpu_sched_data *vgpu_data;
 	struct list_head *pos;
-	static u64 stage_check;
-	int stage = stage_check++ % GVT_TS_BALANCE_STAGE_NUM;
 
-	/* The timeslice accumulation reset at stage 0, which is
-	 * allocated again without adding previous debt.
+	/* Fairness comes from the virtual runtime, only restart the period
+	 * over which caps and reservations are enforced.
 	 */
-	if (stage == 0) {
-		int total_weight = 0;
-		ktime_t fair_timeslice;
-
-		list_for_each(pos, &sched_data->lru_runq_head) {
-			vgpu_data = container_of(pos, struct vgpu_sched_data, lru_list);
-			total_weight += vgpu_data->sched_ctl.weight;
-		}
-
-		list_for_each(pos, &sched_data->lru_runq_head) {
-			vgpu_data = container_of(pos, struct vgpu_sched_data, lru_list);
-			fair_timeslice = ktime_divns(ms_to_ktime(GVT_TS_BALANCE_PERIOD_MS),
-						     total_weight) * vgpu_data->sched_ctl.weight;
-
-			vgpu_data->allocated_ts = fair_timeslice;
-			vgpu_data->left_ts = vgpu_data->allocated_ts;
-		}
-	} else {
-		list_for_each(pos, &sched_data->lru_runq_head) {
-			vgpu_data = container_of(pos, struct vgpu_sched_data, lru_list);
-
-			/* timeslice for next 100ms should add the left/debt
-			 * slice of previous stages.
-			 */
-			vgpu_data->left_ts += vgpu_data->allocated_ts;
-		}
+	list_for_each(pos, &sched_data->lru_runq_head) {
+		vgpu_data = container_of(pos, struct vgpu_sched_data, lru_list);
+		vgpu_data->period_ts = 0;
 	}
 }
 
@@ -162,6 +196,15 @@ static void try_to_schedule_next_vgpu(struct intel_gvt *gvt)
 	vgpu_update_timeslice(scheduler->current_vgpu, cur_time);
 	vgpu_data = scheduler->next_vgpu->sched_data;
 	vgpu_data->sched_in_time = cur_time;
+	vgpu_data->switch_in_time = cur_time;
+	vgpu_data->sched_in_count++;
+	if (vgpu_data->wait_start) {
+		ktime_t wait = ktime_sub(cur_time, vgpu_data->wait_start);
+
+		vgpu_data->wait_time = ktime_add(vgpu_data->wait_time, wait);
+		vgpu_data->max_wait_time = max(vgpu_data->max_wait_time, wait);
+		vgpu_data->wait_start = 0;
+	}
 
 	/* switch current vgpu */
 	scheduler->current_vgpu = scheduler->next_vgpu;
@@ -176,39 +219,89 @@ static void try_to_schedule_next_vgpu(struct intel_gvt *gvt)
 
 static struct intel_vgpu *find_busy_vgpu(struct gvt_sched_data *sched_data)
 {
-	struct vgpu_sched_data *vgpu_data;
-	struct intel_vgpu *vgpu = NULL;
+	struct intel_vgpu *current_vgpu = sched_data->gvt->scheduler.current_vgpu;
+	struct vgpu_sched_data *vgpu_data, *best = NULL, *pri = NULL;
 	struct list_head *head = &sched_data->lru_runq_head;
 	struct list_head *pos;
+	bool best_reserved = false;
+	u64 min_vruntime = U64_MAX;
+	ktime_t now = ktime_get();
 
-	/* search a vgpu with pending workload */
+	/* search the vgpu with pending workload and the least vruntime */
 	list_for_each(pos, head) {
+		bool reserved;
 
 		vgpu_data = container_of(pos, struct vgpu_sched_data, lru_list);
-		if (!vgpu_has_pending_workload(vgpu_data->vgpu))
+		if (!vgpu_has_pending_workload(vgpu_data->vgpu)) {
+			vgpu_data->wait_start = 0;
 			continue;
+		}
+
+		if (vgpu_data->vgpu != current_vgpu && !vgpu_data->wait_start)
+			vgpu_data->wait_start = now;
 
 		if (vgpu_data->pri_sched) {
-			if (ktime_before(ktime_get(), vgpu_data->pri_time)) {
-				vgpu = vgpu_data->vgpu;
-				break;
+			if (ktime_before(now, vgpu_data->pri_time)) {
+				if (!pri)
+					pri = vgpu_data;
+				continue;
 			} else
 				vgpu_data->pri_sched = false;
 		}
 
-		/* Return the vGPU only if it has time slice left */
-		if (vgpu_data->left_ts > 0) {
-			vgpu = vgpu_data->vgpu;
-			break;
+		if (vgpu_over_cap(vgpu_data))
+			continue;
+
+		if (sched_data->min_vruntime > GVT_SCHED_VRUNTIME_SLACK_NS &&
+		    vgpu_data->vruntime < sched_data->min_vruntime -
+					  GVT_SCHED_VRUNTIME_SLACK_NS)
+			vgpu_data->vruntime = sched_data->min_vruntime -
+					      GVT_SCHED_VRUNTIME_SLACK_NS;
+
+		min_vruntime = min(min_vruntime, vgpu_data->vruntime);
+
+		/* vGPUs below their reservation go before everybody else */
+		reserved = vgpu_under_reserve(vgpu_data);
+		if (best && best_reserved && !reserved)
+			continue;
+
+		if (!best || (reserved && !best_reserved) ||
+		    vgpu_data->vruntime < best->vruntime) {
+			best = vgpu_data;
+			best_reserved = reserved;
 		}
 	}
 
-	return vgpu;
+	if (min_vruntime != U64_MAX)
+		sched_data->min_vruntime = max(sched_data->min_vruntime,
+					       min_vruntime);
+
+	if (pri)
+		return pri->vgpu;
+
+	return best ? best->vgpu : NULL;
 }
 
 /* in nanosecond */
 #define GVT_DEFAULT_TIME_SLICE 1000000
 
+/* Keep a busy current vGPU until it used its minimum granularity. */
+static bool vgpu_keep_running(struct intel_vgpu *vgpu, ktime_t now)
+{
+	struct vgpu_sched_data *vgpu_data;
+
+	if (!vgpu || vgpu == vgpu->gvt->idle_vgpu)
+		return false;
+
+	vgpu_data = vgpu->sched_data;
+	if (vgpu_data->pri_sched || vgpu_over_cap(vgpu_data) ||
+	    !vgpu_has_pending_workload(vgpu))
+		return false;
+
+	return ktime_sub(now, vgpu_data->switch_in_time) <
+	       GVT_SCHED_MIN_GRANULARITY_NS;
+}
+
 static void tbs_sched_func(struct gvt_sched_data *sched_data)
 {
 	struct intel_gvt *gvt = sched_data->gvt;
@@ -220,6 +313,9 @@ static void tbs_sched_func(struct gvt_sched_data *sched_data)
 	if (list_empty(&sched_data->lru_runq_head) || scheduler->next_vgpu)
 		goto out;
 
+	if (vgpu_keep_running(scheduler->current_vgpu, ktime_get()))
+		goto out;
+
 	vgpu = find_busy_vgpu(sched_data);
 	if (vgpu) {
 		scheduler->next_vgpu = vgpu;
@@ -316,7 +412,7 @@ static int tbs_sched_init_vgpu(struct intel_vgpu *vgpu)
 	if (!data)
 		return -ENOMEM;
 
-	data->sched_ctl.weight = vgpu->sched_ctl.weight;
+	data->sched_ctl = vgpu->sched_ctl;
 	data->vgpu = vgpu;
 	INIT_LIST_HEAD(&data->lru_list);
 
@@ -352,6 +448,9 @@ static void tbs_sched_start_schedule(struct intel_vgpu *vgpu)
 					ktime_set(GVT_SCHED_VGPU_PRI_TIME, 0));
 	vgpu_data->pri_sched = true;
 
+	/* Start from the current fair point instead of zero. */
+	vgpu_data->vruntime = max(vgpu_data->vruntime, sched_data->min_vruntime);
+
 	list_add(&vgpu_data->lru_list, &sched_data->lru_runq_head);
 
 	if (!hrtimer_active(&sched_data->timer))
@@ -479,3 +578,87 @@ void intel_vgpu_stop_schedule(struct intel_vgpu *vgpu)
 	intel_runtime_pm_put(&dev_priv->runtime_pm, wakeref);
 	mutex_unlock(&vgpu->gvt->sched_lock);
 }
+
+/**
+ * intel_vgpu_sched_workload_complete - account a completed workload
+ * @workload: the workload which has just completed
+ *
+ * Charge the engine time of @workload to its vGPU and, if the vGPU owning
+ * the GPU has run out of workloads, ask for a reschedule right away instead
+ * of waiting for the next scheduler tick. Called with gvt->sched_lock held.
+ */
+void intel_vgpu_sched_workload_complete(struct intel_vgpu_workload *workload)
+{
+	struct intel_vgpu *vgpu = workload->vgpu;
+	struct intel_gvt *gvt = vgpu->gvt;
+	struct vgpu_sched_data *vgpu_data = vgpu->sched_data;
+	enum intel_engine_id id = workload->engine->id;
+	ktime_t busy;
+
+	if (workload->dispatched) {
+		busy = ktime_sub(ktime_get(), workload->dispatch_time);
+		vgpu_data->engine_busy[id] =
+			ktime_add(vgpu_data->engine_busy[id], busy);
+		vgpu_data->engine_vruntime[id] +=
+			vgpu_vruntime_delta(vgpu_data, busy);
+	}
+
+	if (gvt->scheduler.current_vgpu == vgpu &&
+	    !vgpu_has_pending_workload(vgpu))
+		intel_gvt_request_service(gvt, INTEL_GVT_REQUEST_EVENT_SCHED);
+}
+
+/**
+ * intel_vgpu_set_sched_ctl - update the scheduling parameters of a vGPU
+ * @vgpu: a vGPU
+ * @cap: maximum share of GPU time in percent, 0 for no cap
+ * @reserve: guaranteed share of GPU time in percent, 0 for none
+ *
+ * Returns:
+ * Zero on success, -EINVAL if the parameters are out of range.
+ */
+int intel_vgpu_set_sched_ctl(struct intel_vgpu *vgpu, unsigned int cap,
+			     unsigned int reserve)
+{
+	struct vgpu_sched_data *vgpu_data = vgpu->sched_data;
+
+	if (cap > 100 || reserve > 100 || (cap && reserve > cap))
+		return -EINVAL;
+
+	mutex_lock(&vgpu->gvt->sched_lock);
+	vgpu->sched_ctl.cap = cap;
+	vgpu->sched_ctl.reserve = reserve;
+	vgpu_data->sched_ctl = vgpu->sched_ctl;
+	mutex_unlock(&vgpu->gvt->sched_lock);
+
+	return 0;
+}
+
+/**
+ * intel_vgpu_sched_show - dump the scheduling statistics of a vGPU
+ * @vgpu: a vGPU
+ * @m: the seq_file to print to
+ */
+void intel_vgpu_sched_show(struct intel_vgpu *vgpu, struct seq_file *m)
+{
+	struct vgpu_sched_data *vgpu_data = vgpu->sched_data;
+	struct intel_engine_cs *engine;
+	enum intel_engine_id id;
+
+	mutex_lock(&vgpu->gvt->sched_lock);
+	seq_printf(m, "weight: %d cap: %u%% reserve: %u%%\n",
+		   vgpu_data->sched_ctl.weight, vgpu_data->sched_ctl.cap,
+		   vgpu_data->sched_ctl.reserve);
+	seq_printf(m, "vruntime: %llu ns\n", vgpu_data->vruntime);
+	seq_printf(m, "sched time: %lld ns\n", ktime_to_ns(vgpu_data->sched_time));
+	seq_printf(m, "period used: %lld ns\n", ktime_to_ns(vgpu_data->period_ts));
+	seq_printf(m, "sched in: %lu\n", vgpu_data->sched_in_count);
+	seq_printf(m, "wait time: %lld ns (max %lld ns)\n",
+		   ktime_to_ns(vgpu_data->wait_time),
+		   ktime_to_ns(vgpu_data->max_wait_time));
+	for_each_engine(engine, vgpu->gvt->gt, id)
+		seq_printf(m, "%s: busy %lld ns, vruntime %llu ns\n",
+			   engine->name, ktime_to_ns(vgpu_data->engine_busy[id]),
+			   vgpu_data->engine_vruntime[id]);
+	mutex_unlock(&vgpu->gvt->sched_lock);
+}
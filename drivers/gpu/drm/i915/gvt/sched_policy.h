@@ -36,6 +36,8 @@
 
 struct intel_gvt;
 struct intel_vgpu;
+struct intel_vgpu_workload;
+struct seq_file;
 
 struct intel_gvt_sched_policy_ops {
 	int (*init)(struct intel_gvt *gvt);
@@ -62,4 +64,11 @@ void intel_vgpu_stop_schedule(struct intel_vgpu *vgpu);
 
 void intel_gvt_kick_schedule(struct intel_gvt *gvt);
 
+void intel_vgpu_sched_workload_complete(struct intel_vgpu_workload *workload);
+
+int intel_vgpu_set_sched_ctl(struct intel_vgpu *vgpu, unsigned int cap,
+			     unsigned int reserve);
+
+void intel_vgpu_sched_show(struct intel_vgpu *vgpu, struct seq_file *m);
+
 #endif
@@ -502,13 +502,19 @@ int intel_gvt_scan_and_shadow_workload(struct intel_vgpu_workload *workload)
 	if (workload->shadow)
 		return 0;
 
+	/* Don't scan twice a workload which already failed ahead of time. */
+	if (workload->shadow_err)
+		return workload->shadow_err;
+
 	if (!test_and_set_bit(workload->engine->id, s->shadow_ctx_desc_updated))
 		shadow_context_descriptor_update(s->shadow[workload->engine->id],
 						 workload);
 
 	ret = intel_gvt_scan_and_shadow_ringbuffer(workload);
-	if (ret)
+	if (ret) {
+		workload->shadow_err = ret;
 		return ret;
+	}
 
 	if (workload->engine->id == RCS0 &&
 	    workload->wa_ctx.indirect_ctx.size) {
@@ -522,6 +528,7 @@ int intel_gvt_scan_and_shadow_workload(struct intel_vgpu_workload *workload)
 
 err_shadow:
 	release_shadow_wa_ctx(&workload->wa_ctx);
+	workload->shadow_err = ret;
 	return ret;
 }
 
@@ -845,6 +852,7 @@ out:
 			      workload->engine->name, workload->req);
 		i915_request_add(workload->req);
 		workload->dispatched = true;
+		workload->dispatch_time = ktime_get();
 	}
 err_req:
 	if (ret)
@@ -1143,6 +1151,8 @@ static void complete_current_workload(struct intel_gvt *gvt, int ring_id)
 
 	workload->complete(workload);
 
+	intel_vgpu_sched_workload_complete(workload);
+
 	intel_vgpu_shadow_mm_unpin(workload);
 	intel_vgpu_destroy_workload(workload);
 
@@ -1156,6 +1166,61 @@ static void complete_current_workload(struct intel_gvt *gvt, int ring_id)
 	mutex_unlock(&vgpu->vgpu_lock);
 }
 
+static void queue_shadow_work(struct intel_vgpu *vgpu,
+			      const struct intel_engine_cs *engine)
+{
+	struct intel_vgpu_submission *s = &vgpu->submission;
+
+	queue_work(vgpu->gvt->scheduler.shadow_wq,
+		   &s->shadow_work[engine->id].work);
+}
+
+/*
+ * Scan and shadow the next queued workload of a vGPU engine while the
+ * previous one is executing, so that the engine thread finds it ready to
+ * be dispatched. As there is a single ring scan buffer per engine, only the
+ * first workload which hasn't been copied into the ring yet, i.e. the one
+ * right after the dispatched ones, can be shadowed ahead.
+ *
+ * The scan updates vGPU wide state (shadow PPGTT, page tracking, batch
+ * buffer cache) and so still runs under vgpu_lock: dispatch on another
+ * engine of the same vGPU waits for it, only other vGPUs are unaffected.
+ */
+static void shadow_workload_work(struct work_struct *work)
+{
+	struct intel_vgpu_shadow_work *sw =
+		container_of(work, struct intel_vgpu_shadow_work, work);
+	struct intel_vgpu *vgpu = sw->vgpu;
+	struct list_head *q = workload_q_head(vgpu, sw->engine);
+	struct intel_vgpu_workload *workload;
+	intel_wakeref_t wakeref;
+	int ret = 0;
+
+	mutex_lock(&vgpu->vgpu_lock);
+
+	if (!vgpu->submission.active)
+		goto out;
+
+	list_for_each_entry(workload, q, list) {
+		if (!workload->dispatched)
+			break;
+	}
+
+	if (list_entry_is_head(workload, q, list) ||
+	    workload->shadow || workload->shadow_err)
+		goto out;
+
+	with_intel_runtime_pm(sw->engine->gt->uncore->rpm, wakeref)
+		ret = intel_gvt_scan_and_shadow_workload(workload);
+
+	/* The error is reported again when the workload is dispatched. */
+	if (ret)
+		gvt_dbg_sched("ring %s fail to shadow workload %p ahead: %d\n",
+			      sw->engine->name, workload, ret);
+out:
+	mutex_unlock(&vgpu->vgpu_lock);
+}
+
 static int workload_thread(void *arg)
 {
 	struct intel_engine_cs *engine = arg;
@@ -1207,6 +1272,10 @@ static int workload_thread(void *arg)
 
 		ret = dispatch_workload(workload);
 
+		/* The ring scan buffer is free again, shadow the next one. */
+		if (!ret)
+			queue_shadow_work(workload->vgpu, engine);
+
 		if (ret) {
 			vgpu = workload->vgpu;
 			gvt_vgpu_err("fail to dispatch workload, skip\n");
@@ -1262,6 +1331,9 @@ void intel_gvt_clean_workload_scheduler(struct intel_gvt *gvt)
 					&gvt->shadow_ctx_notifier_block[i]);
 		kthread_stop(scheduler->thread[i]);
 	}
+
+	if (scheduler->shadow_wq)
+		destroy_workqueue(scheduler->shadow_wq);
 }
 
 int intel_gvt_init_workload_scheduler(struct intel_gvt *gvt)
@@ -1275,6 +1347,10 @@ int intel_gvt_init_workload_scheduler(struct intel_gvt *gvt)
 
 	init_waitqueue_head(&scheduler->workload_complete_wq);
 
+	scheduler->shadow_wq = alloc_workqueue("gvt-shadow", WQ_UNBOUND, 0);
+	if (!scheduler->shadow_wq)
+		return -ENOMEM;
+
 	for_each_engine(engine, gvt->gt, i) {
 		init_waitqueue_head(&scheduler->waitq[i]);
 
@@ -1340,6 +1416,26 @@ void intel_vgpu_clean_submission(struct intel_vgpu *vgpu)
 }
 
 
+/**
+ * intel_vgpu_cancel_shadow_work - wait for the ahead of time shadowing to stop
+ * @vgpu: a vGPU
+ *
+ * This function is called when a deactivated vGPU is being destroyed, before
+ * taking the vgpu_lock that the shadow works themselves take.
+ *
+ */
+void intel_vgpu_cancel_shadow_work(struct intel_vgpu *vgpu)
+{
+	struct intel_vgpu_submission *s = &vgpu->submission;
+	struct intel_engine_cs *engine;
+	enum intel_engine_id id;
+
+	lockdep_assert_not_held(&vgpu->vgpu_lock);
+
+	for_each_engine(engine, vgpu->gvt->gt, id)
+		cancel_work_sync(&s->shadow_work[id].work);
+}
+
 /**
  * intel_vgpu_reset_submission - reset submission-related resource for vGPU
  * @vgpu: a vGPU
@@ -1407,6 +1503,11 @@ int intel_vgpu_setup_submission(struct intel_vgpu *vgpu)
 		struct intel_context *ce;
 
 		INIT_LIST_HEAD(&s->workload_q_head[i]);
+		INIT_LIST_HEAD(&s->bb_cache[i].entries);
+		s->bb_cache[i].count = 0;
+		s->shadow_work[i].vgpu = vgpu;
+		s->shadow_work[i].engine = engine;
+		INIT_WORK(&s->shadow_work[i].work, shadow_workload_work);
 		s->shadow[i] = ERR_PTR(-EINVAL);
 
 		ce = intel_context_create(engine);
@@ -1790,6 +1891,8 @@ void intel_vgpu_queue_workload(struct intel_vgpu_workload *workload)
 {
 	list_add_tail(&workload->list,
 		      workload_q_head(workload->vgpu, workload->engine));
+	if (!workload->shadow)
+		queue_shadow_work(workload->vgpu, workload->engine);
 	intel_gvt_kick_schedule(workload->vgpu->gvt);
 	wake_up(&workload->vgpu->gvt->scheduler.waitq[workload->engine->id]);
 }
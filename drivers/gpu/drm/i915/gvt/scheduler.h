@@ -54,6 +54,8 @@ struct intel_gvt_workload_scheduler {
 	wait_queue_head_t workload_complete_wq;
 	struct task_struct *thread[I915_NUM_ENGINES];
 	wait_queue_head_t waitq[I915_NUM_ENGINES];
+	/* scans and shadows queued workloads ahead of dispatch */
+	struct workqueue_struct *shadow_wq;
 
 	void *sched_data;
 	const struct intel_gvt_sched_policy_ops *sched_ops;
@@ -88,7 +90,9 @@ struct intel_vgpu_workload {
 	struct i915_request *req;
 	/* if this workload has been dispatched to i915? */
 	bool dispatched;
+	ktime_t dispatch_time;
 	bool shadow;      /* if workload has done shadow of guest request */
+	int shadow_err;   /* sticky error of a failed scan and shadow */
 	int status;
 
 	struct intel_vgpu_mm *shadow_mm;
@@ -149,6 +153,8 @@ void intel_vgpu_reset_submission(struct intel_vgpu *vgpu,
 
 void intel_vgpu_clean_submission(struct intel_vgpu *vgpu);
 
+void intel_vgpu_cancel_shadow_work(struct intel_vgpu *vgpu);
+
 int intel_vgpu_select_submission_ops(struct intel_vgpu *vgpu,
 				     intel_engine_mask_t engine_mask,
 				     unsigned int interface);
@@ -240,6 +240,9 @@ void intel_gvt_destroy_vgpu(struct intel_vgpu *vgpu)
 	idr_remove(&gvt->vgpu_idr, vgpu->id);
 	mutex_unlock(&gvt->lock);
 
+	/* No more workloads can be queued once the vGPU is deactivated */
+	intel_vgpu_cancel_shadow_work(vgpu);
+
 	mutex_lock(&vgpu->vgpu_lock);
 	intel_gvt_debugfs_remove_vgpu(vgpu);
 	intel_vgpu_clean_sched_policy(vgpu);
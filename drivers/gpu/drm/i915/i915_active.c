@@ -17,20 +17,30 @@
 /*
  * Active refs memory management
  *
- * To be more economical with memory, we reap all the i915_active trees as
+ * To be more economical with memory, we reap all the i915_active nodes as
  * they idle (when we know the active requests are inactive) and allocate the
  * nodes from a local slab cache to hopefully reduce the fragmentation.
+ *
+ * The first timeline to use an i915_active claims the inline ref->cache node,
+ * which is all most objects ever need. Any further timelines are stored in
+ * the ref->nodes xarray, indexed by timeline, so that objects shared between
+ * many timelines (such as the GGTT or the buffer pools) can still be looked
+ * up without taking a lock. Nodes only move out of the xarray, or are freed,
+ * once the i915_active is idle or when converted into an idle-barrier.
  */
 static struct kmem_cache *slab_cache;
 
 struct active_node {
-	struct rb_node node;
 	struct i915_active_fence base;
 	struct i915_active *ref;
+	struct active_node *next; /* in ref->barriers, or on an index collision */
 	u64 timeline;
 };
 
-#define fetch_node(x) rb_entry(READ_ONCE(x), typeof(struct active_node), node)
+static inline unsigned long active_index(u64 idx)
+{
+	return idx; /* truncated on 32b, collisions are chained via node->next */
+}
 
 static inline struct active_node *
 node_from_active(struct i915_active_fence *active)
@@ -91,13 +101,13 @@ static void debug_active_init(struct i915_active *ref)
 
 static void debug_active_activate(struct i915_active *ref)
 {
-	lockdep_assert_held(&ref->tree_lock);
+	lockdep_assert_held(&ref->nodes.xa_lock);
 	debug_object_activate(ref, &active_debug_desc);
 }
 
 static void debug_active_deactivate(struct i915_active *ref)
 {
-	lockdep_assert_held(&ref->tree_lock);
+	lockdep_assert_held(&ref->nodes.xa_lock);
 	if (!atomic_read(&ref->count)) /* after the last dec */
 		debug_object_deactivate(ref, &active_debug_desc);
 }
@@ -122,42 +132,55 @@ static inline void debug_active_assert(struct i915_active *ref) { }
 
 #endif
 
+static struct active_node *
+chain_nodes(struct active_node *head, struct active_node *list)
+{
+	while (head) {
+		struct active_node *next = head->next;
+
+		head->next = list;
+		list = head;
+		head = next;
+	}
+
+	return list;
+}
+
 static void
 __active_retire(struct i915_active *ref)
 {
-	struct rb_root root = RB_ROOT;
-	struct active_node *it, *n;
-	unsigned long flags;
+	struct active_node *it, *free;
+	unsigned long flags, index;
 
 	GEM_BUG_ON(i915_active_is_idle(ref));
 
 	/* return the unused nodes to our slabcache -- flushing the allocator */
-	if (!atomic_dec_and_lock_irqsave(&ref->count, &ref->tree_lock, flags))
+	if (!atomic_dec_and_lock_irqsave(&ref->count, &ref->nodes.xa_lock, flags))
 		return;
 
 	GEM_BUG_ON(rcu_access_pointer(ref->excl.fence));
 	debug_active_deactivate(ref);
 
-	/* Even if we have not used the cache, we may still have a barrier */
-	if (!ref->cache)
-		ref->cache = fetch_node(ref->tree.rb_node);
-
-	/* Keep the MRU cached node for reuse */
-	if (ref->cache) {
-		/* Discard all other nodes in the tree */
-		rb_erase(&ref->cache->node, &ref->tree);
-		root = ref->tree;
+	/* Discard all but the inline node */
+	free = chain_nodes(ref->barriers, NULL);
+	WRITE_ONCE(ref->barriers, NULL);
+	xa_for_each(&ref->nodes, index, it) {
+		__xa_erase(&ref->nodes, index);
+		free = chain_nodes(it, free);
+	}
 
-		/* Rebuild the tree with only the cached node */
-		rb_link_node(&ref->cache->node, NULL, &ref->tree.rb_node);
-		rb_insert_color(&ref->cache->node, &ref->tree);
-		GEM_BUG_ON(ref->tree.rb_node != &ref->cache->node);
+	/* Even if we have not used the cache, we may still have a barrier */
+	if (!ref->cache && free) {
+		WRITE_ONCE(ref->cache, free);
+		free = free->next;
+		ref->cache->next = NULL;
+	}
 
-		/* Make the cached node available for reuse with any timeline */
+	/* Make the cached node available for reuse with any timeline */
+	if (ref->cache)
 		ref->cache->timeline = 0; /* needs cmpxchg(u64) */
-	}
 
-	spin_unlock_irqrestore(&ref->tree_lock, flags);
+	spin_unlock_irqrestore(&ref->nodes.xa_lock, flags);
 
 	/* After the final retire, the entire struct may be freed */
 	if (ref->retire)
@@ -166,13 +189,51 @@ __active_retire(struct i915_active *ref)
 	/* ... except if you wait on it, you must manage your own references! */
 	wake_up_var(ref);
 
-	/* Finally free the discarded timeline tree  */
-	rbtree_postorder_for_each_entry_safe(it, n, &root, node) {
+	/* Finally free the discarded timelines */
+	while ((it = free)) {
+		free = it->next;
 		GEM_BUG_ON(i915_active_fence_isset(&it->base));
 		kmem_cache_free(slab_cache, it);
 	}
 }
 
+/*
+ * Visit every node: the inline cache, the barriers and then each timeline in
+ * the xarray. As nodes are only freed once idle, the caller just needs to
+ * hold an active reference.
+ */
+static int active_for_each_node(struct i915_active *ref,
+				int (*fn)(struct active_node *it, void *data),
+				void *data)
+{
+	struct active_node *it;
+	unsigned long index;
+	int err;
+
+	it = READ_ONCE(ref->cache);
+	if (it) {
+		err = fn(it, data);
+		if (err)
+			return err;
+	}
+
+	for (it = READ_ONCE(ref->barriers); it; it = READ_ONCE(it->next)) {
+		err = fn(it, data);
+		if (err)
+			return err;
+	}
+
+	xa_for_each(&ref->nodes, index, it) {
+		do {
+			err = fn(it, data);
+			if (err)
+				return err;
+		} while ((it = READ_ONCE(it->next)));
+	}
+
+	return 0;
+}
+
 static void
 active_work(struct work_struct *wrk)
 {
@@ -229,6 +290,15 @@ excl_retire(struct dma_fence *fence, struct dma_fence_cb *cb)
 		active_retire(container_of(cb, struct i915_active, excl.cb));
 }
 
+static struct active_node *
+__active_find(struct active_node *it, u64 idx)
+{
+	while (it && READ_ONCE(it->timeline) != idx)
+		it = READ_ONCE(it->next);
+
+	return it;
+}
+
 static struct active_node *__active_lookup(struct i915_active *ref, u64 idx)
 {
 	struct active_node *it;
@@ -236,11 +306,11 @@ static struct active_node *__active_lookup(struct i915_active *ref, u64 idx)
 	GEM_BUG_ON(idx == 0); /* 0 is the unordered timeline, rsvd for cache */
 
 	/*
-	 * We track the most recently used timeline to skip a rbtree search
-	 * for the common case, under typical loads we never need the rbtree
-	 * at all. We can reuse the last slot if it is empty, that is
-	 * after the previous activity has been retired, or if it matches the
-	 * current timeline.
+	 * The inline node is claimed by the first timeline to use this
+	 * i915_active after it idled, and under typical loads we never need
+	 * to look any further. The inline node can be reused if it is empty,
+	 * that is after the previous activity has been retired, or if it
+	 * matches the current timeline.
 	 */
 	it = READ_ONCE(ref->cache);
 	if (it) {
@@ -263,75 +333,70 @@ static struct active_node *__active_lookup(struct i915_active *ref, u64 idx)
 			return it;
 	}
 
-	BUILD_BUG_ON(offsetof(typeof(*it), node));
-
-	/* While active, the tree can only be built; not destroyed */
+	/* While active, nodes can only be added; not freed */
 	GEM_BUG_ON(i915_active_is_idle(ref));
 
-	it = fetch_node(ref->tree.rb_node);
-	while (it) {
-		if (it->timeline < idx) {
-			it = fetch_node(it->node.rb_right);
-		} else if (it->timeline > idx) {
-			it = fetch_node(it->node.rb_left);
-		} else {
-			WRITE_ONCE(ref->cache, it);
-			break;
-		}
-	}
-
-	/* NB: If the tree rotated beneath us, we may miss our target. */
-	return it;
+	/* xa_load() is RCU safe, so shared objects do not contend here */
+	return __active_find(xa_load(&ref->nodes, active_index(idx)), idx);
 }
 
 static struct i915_active_fence *
 active_instance(struct i915_active *ref, u64 idx)
 {
-	struct active_node *node;
-	struct rb_node **p, *parent;
+	struct active_node *node, *prealloc, *head;
+	void *old;
 
 	node = __active_lookup(ref, idx);
 	if (likely(node))
 		return &node->base;
 
-	spin_lock_irq(&ref->tree_lock);
-	GEM_BUG_ON(i915_active_is_idle(ref));
-
-	parent = NULL;
-	p = &ref->tree.rb_node;
-	while (*p) {
-		parent = *p;
-
-		node = rb_entry(parent, struct active_node, node);
-		if (node->timeline == idx)
-			goto out;
-
-		if (node->timeline < idx)
-			p = &parent->rb_right;
-		else
-			p = &parent->rb_left;
-	}
-
 	/*
 	 * XXX: We should preallocate this before i915_active_ref() is ever
 	 *  called, but we cannot call into fs_reclaim() anyway, so use GFP_ATOMIC.
 	 */
-	node = kmem_cache_alloc(slab_cache, GFP_ATOMIC);
-	if (!node)
+	prealloc = kmem_cache_alloc(slab_cache, GFP_ATOMIC);
+	if (!prealloc)
+		return NULL;
+
+	__i915_active_fence_init(&prealloc->base, NULL, node_retire);
+	prealloc->ref = ref;
+	prealloc->next = NULL;
+	prealloc->timeline = idx;
+
+	xa_lock_irq(&ref->nodes);
+	GEM_BUG_ON(i915_active_is_idle(ref));
+
+	/* Did we race with another thread adding the same timeline? */
+	node = ref->cache;
+	if (node && node->timeline == idx)
+		goto out;
+
+	if (!node) {
+		node = prealloc;
+		prealloc = NULL;
+		WRITE_ONCE(ref->cache, node);
 		goto out;
+	}
 
-	__i915_active_fence_init(&node->base, NULL, node_retire);
-	node->ref = ref;
-	node->timeline = idx;
+	head = xa_load(&ref->nodes, active_index(idx));
+	node = __active_find(head, idx);
+	if (node)
+		goto out;
 
-	rb_link_node(&node->node, parent, p);
-	rb_insert_color(&node->node, &ref->tree);
+	prealloc->next = head;
+	old = __xa_store(&ref->nodes, active_index(idx), prealloc, GFP_ATOMIC);
+	if (!xa_is_err(old)) {
+		node = prealloc;
+		prealloc = NULL;
+	}
 
 out:
-	WRITE_ONCE(ref->cache, node);
-	spin_unlock_irq(&ref->tree_lock);
+	xa_unlock_irq(&ref->nodes);
 
-	return &node->base;
+	if (prealloc)
+		kmem_cache_free(slab_cache, prealloc);
+
+	return node ? &node->base : NULL;
 }
 
 void __i915_active_init(struct i915_active *ref,
@@ -347,9 +412,9 @@ void __i915_active_init(struct i915_active *ref,
 	ref->active = active;
 	ref->retire = retire;
 
-	spin_lock_init(&ref->tree_lock);
-	ref->tree = RB_ROOT;
+	xa_init_flags(&ref->nodes, XA_FLAGS_LOCK_IRQ);
 	ref->cache = NULL;
+	ref->barriers = NULL;
 
 	init_llist_head(&ref->preallocated_barriers);
 	atomic_set(&ref->count, 0);
@@ -430,7 +495,7 @@ int i915_active_add_request(struct i915_active *ref, struct i915_request *rq)
 	struct i915_active_fence *active;
 	int err;
 
-	/* Prevent reaping in case we malloc/wait while building the tree */
+	/* Prevent reaping in case we malloc/wait while adding nodes */
 	err = i915_active_acquire(ref);
 	if (err)
 		return err;
@@ -493,10 +558,10 @@ bool i915_active_acquire_if_busy(struct i915_active *ref)
 
 static void __i915_active_activate(struct i915_active *ref)
 {
-	spin_lock_irq(&ref->tree_lock); /* __active_retire() */
+	xa_lock_irq(&ref->nodes); /* __active_retire() */
 	if (!atomic_fetch_inc(&ref->count))
 		debug_active_activate(ref);
-	spin_unlock_irq(&ref->tree_lock);
+	xa_unlock_irq(&ref->nodes);
 }
 
 int i915_active_acquire(struct i915_active *ref)
@@ -562,21 +627,22 @@ static int flush_barrier(struct active_node *it)
 	return intel_engine_flush_barriers(engine);
 }
 
-static int flush_lazy_signals(struct i915_active *ref)
+static int flush_lazy_signal(struct active_node *it, void *data)
 {
-	struct active_node *it, *n;
-	int err = 0;
+	int err;
 
-	enable_signaling(&ref->excl);
-	rbtree_postorder_for_each_entry_safe(it, n, &ref->tree, node) {
-		err = flush_barrier(it); /* unconnected idle barrier? */
-		if (err)
-			break;
+	err = flush_barrier(it); /* unconnected idle barrier? */
+	if (err)
+		return err;
 
-		enable_signaling(&it->base);
-	}
+	enable_signaling(&it->base);
+	return 0;
+}
 
-	return err;
+static int flush_lazy_signals(struct i915_active *ref)
+{
+	enable_signaling(&ref->excl);
+	return active_for_each_node(ref, flush_lazy_signal, NULL);
 }
 
 int __i915_active_wait(struct i915_active *ref, int state)
@@ -627,6 +693,18 @@ static int __await_active(struct i915_active_fence *active,
 	return 0;
 }
 
+struct await_node {
+	int (*fn)(void *arg, struct dma_fence *fence);
+	void *arg;
+};
+
+static int await_node(struct active_node *it, void *data)
+{
+	struct await_node *await = data;
+
+	return __await_active(&it->base, await->fn, await->arg);
+}
+
 struct wait_barrier {
 	struct wait_queue_entry base;
 	struct i915_active *ref;
@@ -687,13 +765,11 @@ static int await_active(struct i915_active *ref,
 	}
 
 	if (flags & I915_ACTIVE_AWAIT_ACTIVE) {
-		struct active_node *it, *n;
+		struct await_node await = { .fn = fn, .arg = arg };
 
-		rbtree_postorder_for_each_entry_safe(it, n, &ref->tree, node) {
-			err = __await_active(&it->base, fn, arg);
-			if (err)
-				goto out;
-		}
+		err = active_for_each_node(ref, await_node, &await);
+		if (err)
+			goto out;
 	}
 
 	if (flags & I915_ACTIVE_AWAIT_BARRIER) {
@@ -741,10 +817,12 @@ void i915_active_fini(struct i915_active *ref)
 	debug_active_fini(ref);
 	GEM_BUG_ON(atomic_read(&ref->count));
 	GEM_BUG_ON(work_pending(&ref->work));
+	GEM_BUG_ON(!xa_empty(&ref->nodes) || ref->barriers);
 	mutex_destroy(&ref->mutex);
 
 	if (ref->cache)
 		kmem_cache_free(slab_cache, ref->cache);
+	xa_destroy(&ref->nodes);
 }
 
 static inline bool is_idle_barrier(struct active_node *node, u64 idx)
@@ -752,87 +830,109 @@ static inline bool is_idle_barrier(struct active_node *node, u64 idx)
 	return node->timeline == idx && !i915_active_fence_isset(&node->base);
 }
 
-static struct active_node *reuse_idle_barrier(struct i915_active *ref, u64 idx)
+static bool claim_barrier(struct i915_active *ref,
+			  struct active_node *node, u64 idx)
 {
-	struct rb_node *prev, *p;
-
-	if (RB_EMPTY_ROOT(&ref->tree))
-		return NULL;
+	struct intel_engine_cs *engine;
 
-	GEM_BUG_ON(i915_active_is_idle(ref));
+	if (node->timeline != idx)
+		return false;
 
 	/*
-	 * Try to reuse any existing barrier nodes already allocated for this
-	 * i915_active, due to overlapping active phases there is likely a
-	 * node kept alive (as we reuse before parking). We prefer to reuse
-	 * completely idle barriers (less hassle in manipulating the llists),
-	 * but otherwise any will do.
+	 * The list of pending barriers is protected by the
+	 * kernel_context timeline, which notably we do not hold
+	 * here. i915_request_add_active_barriers() may consume
+	 * the barrier before we claim it, so we have to check
+	 * for success.
 	 */
-	if (ref->cache && is_idle_barrier(ref->cache, idx)) {
-		p = &ref->cache->node;
-		goto match;
+	engine = __barrier_to_engine(node);
+	smp_rmb(); /* serialise with add_active_barriers */
+	return is_barrier(&node->base) &&
+		____active_del_barrier(ref, node, engine);
+}
+
+static void unlink_node(struct i915_active *ref, struct active_node *node)
+{
+	struct active_node **p, *head;
+	unsigned long index;
+
+	lockdep_assert_held(&ref->nodes.xa_lock);
+
+	if (node == ref->cache) {
+		WRITE_ONCE(ref->cache, NULL);
+		return;
 	}
 
-	prev = NULL;
-	p = ref->tree.rb_node;
-	while (p) {
-		struct active_node *node =
-			rb_entry(p, struct active_node, node);
+	for (p = &ref->barriers; *p; p = &(*p)->next) {
+		if (*p == node) {
+			WRITE_ONCE(*p, node->next);
+			return;
+		}
+	}
 
-		if (is_idle_barrier(node, idx))
-			goto match;
+	index = active_index(node->timeline);
+	head = xa_load(&ref->nodes, index);
+	if (!head)
+		return;
 
-		prev = p;
-		if (node->timeline < idx)
-			p = READ_ONCE(p->rb_right);
+	if (head == node) {
+		/* Replacing an existing entry never allocates */
+		if (node->next)
+			__xa_store(&ref->nodes, index, node->next, 0);
 		else
-			p = READ_ONCE(p->rb_left);
+			__xa_erase(&ref->nodes, index);
+		return;
 	}
 
-	/*
-	 * No quick match, but we did find the leftmost rb_node for the
-	 * kernel_context. Walk the rb_tree in-order to see if there were
-	 * any idle-barriers on this timeline that we missed, or just use
-	 * the first pending barrier.
-	 */
-	for (p = prev; p; p = rb_next(p)) {
-		struct active_node *node =
-			rb_entry(p, struct active_node, node);
-		struct intel_engine_cs *engine;
+	for (p = &head->next; *p; p = &(*p)->next) {
+		if (*p == node) {
+			WRITE_ONCE(*p, node->next);
+			return;
+		}
+	}
+}
 
-		if (node->timeline > idx)
-			break;
+static struct active_node *reuse_idle_barrier(struct i915_active *ref, u64 idx)
+{
+	struct active_node *head[3], *node;
+	int i;
 
-		if (node->timeline < idx)
-			continue;
+	GEM_BUG_ON(i915_active_is_idle(ref));
 
-		if (is_idle_barrier(node, idx))
-			goto match;
+	/*
+	 * Try to reuse any existing barrier nodes already allocated for this
+	 * i915_active, due to overlapping active phases there is likely a
+	 * node kept alive (as we reuse before parking). We prefer to reuse
+	 * completely idle barriers (less hassle in manipulating the llists),
+	 * but otherwise any will do. Only the inline node, the barriers and
+	 * the nodes sharing the kernel_context index are candidates.
+	 */
+	head[0] = READ_ONCE(ref->cache);
+	head[1] = READ_ONCE(ref->barriers);
+	head[2] = xa_load(&ref->nodes, active_index(idx));
+
+	for (i = 0; i < ARRAY_SIZE(head); i++) {
+		for (node = head[i]; node; node = READ_ONCE(node->next)) {
+			if (is_idle_barrier(node, idx))
+				goto match;
+		}
+	}
 
-		/*
-		 * The list of pending barriers is protected by the
-		 * kernel_context timeline, which notably we do not hold
-		 * here. i915_request_add_active_barriers() may consume
-		 * the barrier before we claim it, so we have to check
-		 * for success.
-		 */
-		engine = __barrier_to_engine(node);
-		smp_rmb(); /* serialise with add_active_barriers */
-		if (is_barrier(&node->base) &&
-		    ____active_del_barrier(ref, node, engine))
-			goto match;
+	for (i = 0; i < ARRAY_SIZE(head); i++) {
+		for (node = head[i]; node; node = READ_ONCE(node->next)) {
+			if (claim_barrier(ref, node, idx))
+				goto match;
+		}
 	}
 
 	return NULL;
 
 match:
-	spin_lock_irq(&ref->tree_lock);
-	rb_erase(p, &ref->tree); /* Hide from waits and sibling allocations */
-	if (p == &ref->cache->node)
-		WRITE_ONCE(ref->cache, NULL);
-	spin_unlock_irq(&ref->tree_lock);
+	xa_lock_irq(&ref->nodes);
+	unlink_node(ref, node); /* Hide from waits and sibling allocations */
+	xa_unlock_irq(&ref->nodes);
 
-	return rb_entry(p, struct active_node, node);
+	return node;
 }
 
 int i915_active_acquire_preallocate_barrier(struct i915_active *ref,
@@ -871,6 +971,7 @@ int i915_active_acquire_preallocate_barrier(struct i915_active *ref,
 			RCU_INIT_POINTER(node->base.fence, NULL);
 			node->base.cb.func = node_retire;
 			node->timeline = idx;
+			node->next = NULL;
 			node->ref = ref;
 		}
 
@@ -879,10 +980,10 @@ int i915_active_acquire_preallocate_barrier(struct i915_active *ref,
 			 * Mark this as being *our* unconnected proto-node.
 			 *
 			 * Since this node is not in any list, and we have
-			 * decoupled it from the rbtree, we can reuse the
+			 * decoupled it from the i915_active, we can reuse the
 			 * request to indicate this is an idle-barrier node
-			 * and then we can use the rb_node and list pointers
-			 * for our tracking of the pending barrier.
+			 * and then we can use the list pointers for our
+			 * tracking of the pending barrier.
 			 */
 			RCU_INIT_POINTER(node->base.fence, ERR_PTR(-EAGAIN));
 			node->base.cb.node.prev = (void *)engine;
@@ -926,33 +1027,25 @@ void i915_active_acquire_barrier(struct i915_active *ref)
 
 	/*
 	 * Transfer the list of preallocated barriers into the
-	 * i915_active rbtree, but only as proto-nodes. They will be
+	 * i915_active, but only as proto-nodes. They will be
 	 * populated by i915_request_add_active_barriers() to point to the
 	 * request that will eventually release them.
 	 */
 	llist_for_each_safe(pos, next, take_preallocated_barriers(ref)) {
 		struct active_node *node = barrier_from_ll(pos);
 		struct intel_engine_cs *engine = barrier_to_engine(node);
-		struct rb_node **p, *parent;
 
-		spin_lock_irqsave_nested(&ref->tree_lock, flags,
+		/*
+		 * The kernel_context timeline may already have a node of its
+		 * own, so rather than compete for its index keep the barriers
+		 * on their own list; which also means we never need to
+		 * allocate here.
+		 */
+		spin_lock_irqsave_nested(&ref->nodes.xa_lock, flags,
 					 SINGLE_DEPTH_NESTING);
-		parent = NULL;
-		p = &ref->tree.rb_node;
-		while (*p) {
-			struct active_node *it;
-
-			parent = *p;
-
-			it = rb_entry(parent, struct active_node, node);
-			if (it->timeline < node->timeline)
-				p = &parent->rb_right;
-			else
-				p = &parent->rb_left;
-		}
-		rb_link_node(&node->node, parent, p);
-		rb_insert_color(&node->node, &ref->tree);
-		spin_unlock_irqrestore(&ref->tree_lock, flags);
+		node->next = ref->barriers;
+		smp_store_release(&ref->barriers, node);
+		spin_unlock_irqrestore(&ref->nodes.xa_lock, flags);
 
 		GEM_BUG_ON(!intel_engine_pm_is_awake(engine));
 		llist_add(barrier_to_ll(node), &engine->barrier_tasks);
@@ -11,9 +11,9 @@
 #include <linux/dma-fence.h>
 #include <linux/llist.h>
 #include <linux/mutex.h>
-#include <linux/rbtree.h>
 #include <linux/rcupdate.h>
 #include <linux/workqueue.h>
+#include <linux/xarray.h>
 
 struct i915_active_fence {
 	struct dma_fence __rcu *fence;
@@ -26,9 +26,11 @@ struct i915_active {
 	atomic_t count;
 	struct mutex mutex;
 
-	spinlock_t tree_lock;
+	/* The first timeline is tracked inline, the rest by timeline id */
 	struct active_node *cache;
-	struct rb_root tree;
+	struct xarray nodes;
+	/* Idle-barrier nodes, kept aside as they may share a timeline */
+	struct active_node *barriers;
 
 	/* Preallocated "exclusive" node */
 	struct i915_active_fence excl;
@@ -263,7 +263,9 @@ static int i915_driver_early_probe(struct drm_i915_private *dev_priv)
 	if (ret < 0)
 		goto err_rootgt;
 
-	i915_gem_init_early(dev_priv);
+	ret = i915_gem_init_early(dev_priv);
+	if (ret < 0)
+		goto err_rootgt;
 
 	intel_irq_init(dev_priv);
 	intel_display_driver_early_probe(display);
@@ -31,6 +31,7 @@ struct i915_drm_client *i915_drm_client_alloc(void)
 #ifdef CONFIG_PROC_FS
 	spin_lock_init(&client->objects_lock);
 	INIT_LIST_HEAD(&client->objects_list);
+	INIT_LIST_HEAD(&client->active_list);
 #endif
 
 	return client;
@@ -45,6 +46,241 @@ void __i915_drm_client_free(struct kref *kref)
 }
 
 #ifdef CONFIG_PROC_FS
+#define I915_DRM_CLIENT_OBJ_SHARED	BIT(0)
+#define I915_DRM_CLIENT_OBJ_RESIDENT	BIT(1)
+#define I915_DRM_CLIENT_OBJ_PURGEABLE	BIT(2)
+
+static unsigned int obj_region(const struct drm_i915_gem_object *obj)
+{
+	return obj->mm.region ? obj->mm.region->id : INTEL_REGION_SMEM;
+}
+
+static unsigned int
+obj_state(const struct drm_i915_gem_object *obj, int handles, bool exported)
+{
+	unsigned int state = 0;
+
+	/* As drm_gem_object_is_shared_for_memory_stats() */
+	if (handles > 1 || obj->base.dma_buf || exported)
+		state |= I915_DRM_CLIENT_OBJ_SHARED;
+
+	if (i915_gem_object_has_pages(obj)) {
+		state |= I915_DRM_CLIENT_OBJ_RESIDENT;
+
+		if (i915_gem_object_is_shrinkable(obj) &&
+		    obj->mm.madv == I915_MADV_DONTNEED)
+			state |= I915_DRM_CLIENT_OBJ_PURGEABLE;
+	}
+
+	return state;
+}
+
+static void stats_add(struct i915_drm_client *client,
+		      unsigned int region, unsigned int state, s64 sz)
+{
+	struct i915_drm_client_stats *stats = &client->stats[region];
+
+	if (state & I915_DRM_CLIENT_OBJ_SHARED)
+		atomic64_add(sz, &stats->shared);
+	else
+		atomic64_add(sz, &stats->private);
+
+	if (state & I915_DRM_CLIENT_OBJ_RESIDENT)
+		atomic64_add(sz, &stats->resident);
+
+	if (state & I915_DRM_CLIENT_OBJ_PURGEABLE)
+		atomic64_add(sz, &stats->purgeable);
+}
+
+static void
+__update_object(struct drm_i915_gem_object *obj, int handles, bool exported)
+{
+	unsigned int region = obj_region(obj);
+	unsigned int state = obj_state(obj, handles, exported);
+	struct i915_drm_client_link *link;
+
+	lockdep_assert_held(&obj->client_stats.lock);
+
+	if (region == obj->client_stats.region &&
+	    state == obj->client_stats.state)
+		return;
+
+	list_for_each_entry(link, &obj->client_stats.links, obj_link) {
+		stats_add(link->client,
+			  obj->client_stats.region, obj->client_stats.state,
+			  -(s64)obj->base.size);
+		stats_add(link->client, region, state, obj->base.size);
+	}
+
+	obj->client_stats.region = region;
+	obj->client_stats.state = state;
+}
+
+static void update_object(struct drm_i915_gem_object *obj,
+			  int handle_bias, bool exported)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&obj->client_stats.lock, flags);
+	__update_object(obj,
+			READ_ONCE(obj->base.handle_count) + handle_bias,
+			exported);
+	spin_unlock_irqrestore(&obj->client_stats.lock, flags);
+}
+
+static void link_object(struct i915_drm_client_link *link,
+			struct i915_drm_client *client,
+			struct drm_i915_gem_object *obj)
+{
+	unsigned long flags;
+
+	link->obj = obj;
+	link->client = client;
+	INIT_LIST_HEAD(&link->active_link);
+
+	spin_lock_irqsave(&obj->client_stats.lock, flags);
+	__update_object(obj, READ_ONCE(obj->base.handle_count), false);
+	stats_add(client,
+		  obj->client_stats.region, obj->client_stats.state,
+		  obj->base.size);
+	list_add_tail(&link->obj_link, &obj->client_stats.links);
+	spin_unlock_irqrestore(&obj->client_stats.lock, flags);
+}
+
+static void __unlink_object(struct i915_drm_client_link *link, int handle_bias)
+{
+	struct drm_i915_gem_object *obj = link->obj;
+	struct i915_drm_client *client = link->client;
+
+	lockdep_assert_held(&obj->client_stats.lock);
+
+	list_del(&link->obj_link);
+	stats_add(client,
+		  obj->client_stats.region, obj->client_stats.state,
+		  -(s64)obj->base.size);
+
+	spin_lock(&client->objects_lock);
+	if (!list_empty(&link->active_link)) {
+		list_del_init(&link->active_link);
+		client->stats[link->active_region].active -= obj->base.size;
+	}
+	spin_unlock(&client->objects_lock);
+
+	__update_object(obj,
+			READ_ONCE(obj->base.handle_count) + handle_bias,
+			false);
+}
+
+void i915_drm_client_init_object(struct drm_i915_gem_object *obj)
+{
+	spin_lock_init(&obj->client_stats.lock);
+	INIT_LIST_HEAD(&obj->client_stats.links);
+	obj->client_stats.region = obj_region(obj);
+	obj->client_stats.state = 0;
+}
+
+/**
+ * i915_drm_client_open_object - account a new handle to an object
+ * @client: the client owning the handle
+ * @obj: the object
+ *
+ * Returns: zero on success or -ENOMEM.
+ */
+int i915_drm_client_open_object(struct i915_drm_client *client,
+				struct drm_i915_gem_object *obj)
+{
+	struct i915_drm_client_link *link;
+
+	link = kmalloc_obj(*link);
+	if (!link)
+		return -ENOMEM;
+
+	link_object(link, client, obj);
+
+	return 0;
+}
+
+/**
+ * i915_drm_client_close_object - stop accounting a closed handle
+ * @client: the client owning the handle
+ * @obj: the object
+ *
+ * Called before the handle is dropped from @obj's handle count.
+ */
+void i915_drm_client_close_object(struct i915_drm_client *client,
+				  struct drm_i915_gem_object *obj)
+{
+	struct i915_drm_client_link *link, *found = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&obj->client_stats.lock, flags);
+	list_for_each_entry(link, &obj->client_stats.links, obj_link) {
+		if (link->client == client &&
+		    link != &obj->client_stats.owner) {
+			__unlink_object(link, -1);
+			found = link;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&obj->client_stats.lock, flags);
+
+	kfree(found);
+}
+
+/**
+ * i915_drm_client_update_object - reaccount an object after a state change
+ * @obj: the object
+ *
+ * Must be called whenever the backing store, memory region or purgeability
+ * of @obj changes.
+ */
+void i915_drm_client_update_object(struct drm_i915_gem_object *obj)
+{
+	update_object(obj, 0, false);
+}
+
+/**
+ * i915_drm_client_export_object - account an object as shared via dma-buf
+ * @obj: the object being exported
+ *
+ * Called on export, before the dma-buf is attached to @obj.
+ */
+void i915_drm_client_export_object(struct drm_i915_gem_object *obj)
+{
+	update_object(obj, 0, true);
+}
+
+/**
+ * i915_drm_client_object_active - account an object as active
+ * @obj: the object which has been added to a request
+ *
+ * Activity is tracked lazily: the object stays accounted as active in each
+ * client until the statistics are read and its fences have signaled.
+ */
+void i915_drm_client_object_active(struct drm_i915_gem_object *obj)
+{
+	struct i915_drm_client_link *link;
+	unsigned long flags;
+
+	if (list_empty_careful(&obj->client_stats.links))
+		return;
+
+	spin_lock_irqsave(&obj->client_stats.lock, flags);
+	list_for_each_entry(link, &obj->client_stats.links, obj_link) {
+		struct i915_drm_client *client = link->client;
+
+		if (!list_empty(&link->active_link))
+			continue;
+
+		spin_lock(&client->objects_lock);
+		link->active_region = obj->client_stats.region;
+		client->stats[link->active_region].active += obj->base.size;
+		list_add_tail(&link->active_link, &client->active_list);
+		spin_unlock(&client->objects_lock);
+	}
+	spin_unlock_irqrestore(&obj->client_stats.lock, flags);
+}
+
 static void
 obj_meminfo(struct drm_i915_gem_object *obj,
 	    struct drm_memory_stats stats[INTEL_REGION_UNKNOWN])
@@ -70,14 +306,13 @@ obj_meminfo(struct drm_i915_gem_object *obj,
 	}
 }
 
-static void show_meminfo(struct drm_printer *p, struct drm_file *file)
+static void
+walk_meminfo(struct drm_file *file,
+	     struct drm_memory_stats stats[INTEL_REGION_UNKNOWN])
 {
-	struct drm_memory_stats stats[INTEL_REGION_UNKNOWN] = {};
 	struct drm_i915_file_private *fpriv = file->driver_priv;
 	struct i915_drm_client *client = fpriv->client;
-	struct drm_i915_private *i915 = fpriv->i915;
 	struct drm_i915_gem_object *obj;
-	struct intel_memory_region *mr;
 	struct list_head __rcu *pos;
 	unsigned int id;
 
@@ -98,6 +333,80 @@ static void show_meminfo(struct drm_printer *p, struct drm_file *file)
 		i915_gem_object_put(obj);
 	}
 	rcu_read_unlock();
+}
+
+/*
+ * With CONFIG_DRM_I915_DEBUG_GEM, cross-check the running statistics against
+ * a walk over all objects of the client. The walk races with concurrent
+ * state changes, so this is only meaningful for a quiescent client. Activity
+ * is tracked lazily and so is not compared.
+ */
+static void
+check_meminfo(struct drm_file *file,
+	      const struct drm_memory_stats stats[INTEL_REGION_UNKNOWN])
+{
+	struct drm_i915_file_private *fpriv = file->driver_priv;
+	struct drm_memory_stats *walk;
+	unsigned int id;
+
+	if (!IS_ENABLED(CONFIG_DRM_I915_DEBUG_GEM))
+		return;
+
+	walk = kzalloc_objs(*walk, INTEL_REGION_UNKNOWN);
+	if (!walk)
+		return;
+
+	walk_meminfo(file, walk);
+
+	for (id = 0; id < INTEL_REGION_UNKNOWN; id++)
+		drm_WARN_ONCE(&fpriv->i915->drm,
+			      stats[id].private != walk[id].private ||
+			      stats[id].shared != walk[id].shared ||
+			      stats[id].resident != walk[id].resident,
+			      "fdinfo region %u: private %llu/%llu, shared %llu/%llu, resident %llu/%llu\n",
+			      id,
+			      stats[id].private, walk[id].private,
+			      stats[id].shared, walk[id].shared,
+			      stats[id].resident, walk[id].resident);
+
+	kfree(walk);
+}
+
+static void show_meminfo(struct drm_printer *p, struct drm_file *file)
+{
+	struct drm_memory_stats stats[INTEL_REGION_UNKNOWN] = {};
+	struct drm_i915_file_private *fpriv = file->driver_priv;
+	struct i915_drm_client *client = fpriv->client;
+	struct drm_i915_private *i915 = fpriv->i915;
+	struct i915_drm_client_link *link, *next;
+	struct intel_memory_region *mr;
+	unsigned long flags;
+	unsigned int id;
+
+	/* Drop the objects which have idled since the last read. */
+	spin_lock_irqsave(&client->objects_lock, flags);
+	list_for_each_entry_safe(link, next, &client->active_list, active_link) {
+		if (!dma_resv_test_signaled(link->obj->base.resv,
+					    DMA_RESV_USAGE_BOOKKEEP))
+			continue;
+
+		list_del_init(&link->active_link);
+		client->stats[link->active_region].active -=
+			link->obj->base.size;
+	}
+
+	for (id = 0; id < INTEL_REGION_UNKNOWN; id++)
+		stats[id].active = client->stats[id].active;
+	spin_unlock_irqrestore(&client->objects_lock, flags);
+
+	for (id = 0; id < INTEL_REGION_UNKNOWN; id++) {
+		stats[id].private = atomic64_read(&client->stats[id].private);
+		stats[id].shared = atomic64_read(&client->stats[id].shared);
+		stats[id].resident = atomic64_read(&client->stats[id].resident);
+		stats[id].purgeable = atomic64_read(&client->stats[id].purgeable);
+	}
+
+	check_meminfo(file, stats);
 
 	for_each_memory_region(mr, i915, id)
 		drm_print_memory_stats(p,
@@ -190,6 +499,8 @@ void i915_drm_client_add_object(struct i915_drm_client *client,
 	obj->client = i915_drm_client_get(client);
 	list_add_tail_rcu(&obj->client_link, &client->objects_list);
 	spin_unlock_irqrestore(&client->objects_lock, flags);
+
+	link_object(&obj->client_stats.owner, client, obj);
 }
 
 void i915_drm_client_remove_object(struct drm_i915_gem_object *obj)
@@ -201,6 +512,10 @@ void i915_drm_client_remove_object(struct drm_i915_gem_object *obj)
 	if (!client)
 		return;
 
+	spin_lock_irqsave(&obj->client_stats.lock, flags);
+	__unlink_object(&obj->client_stats.owner, 0);
+	spin_unlock_irqrestore(&obj->client_stats.lock, flags);
+
 	spin_lock_irqsave(&client->objects_lock, flags);
 	list_del_rcu(&obj->client_link);
 	spin_unlock_irqrestore(&client->objects_lock, flags);
@@ -15,12 +15,27 @@
 #include "i915_file_private.h"
 #include "gem/i915_gem_object_types.h"
 #include "gt/intel_context_types.h"
+#include "intel_memory_region.h"
 
 #define I915_LAST_UABI_ENGINE_CLASS I915_ENGINE_CLASS_COMPUTE
 
 struct drm_file;
 struct drm_printer;
 
+/*
+ * Running per-region memory statistics of a client, for the drm-memory-*
+ * fdinfo keys. Sizes are accounted as objects change state, rather than
+ * being summed up on every fdinfo read.
+ */
+struct i915_drm_client_stats {
+	atomic64_t private;
+	atomic64_t shared;
+	atomic64_t resident;
+	atomic64_t purgeable;
+	/* Protected by i915_drm_client.objects_lock */
+	u64 active;
+};
+
 struct i915_drm_client {
 	struct kref kref;
 
@@ -39,6 +54,19 @@ struct i915_drm_client {
 	 * Protected by @objects_lock.
 	 */
 	struct list_head objects_list;
+
+	/**
+	 * @active_list: list of i915_drm_client_link accounted as active,
+	 * pruned of idle objects when the statistics are read
+	 *
+	 * Protected by @objects_lock.
+	 */
+	struct list_head active_list;
+
+	/**
+	 * @stats: memory statistics of the objects linked to the client
+	 */
+	struct i915_drm_client_stats stats[INTEL_REGION_UNKNOWN];
 #endif
 
 	/**
@@ -71,6 +99,15 @@ void i915_drm_client_add_object(struct i915_drm_client *client,
 void i915_drm_client_remove_object(struct drm_i915_gem_object *obj);
 void i915_drm_client_add_context_objects(struct i915_drm_client *client,
 					 struct intel_context *ce);
+
+void i915_drm_client_init_object(struct drm_i915_gem_object *obj);
+int i915_drm_client_open_object(struct i915_drm_client *client,
+				struct drm_i915_gem_object *obj);
+void i915_drm_client_close_object(struct i915_drm_client *client,
+				  struct drm_i915_gem_object *obj);
+void i915_drm_client_update_object(struct drm_i915_gem_object *obj);
+void i915_drm_client_export_object(struct drm_i915_gem_object *obj);
+void i915_drm_client_object_active(struct drm_i915_gem_object *obj);
 #else
 static inline void i915_drm_client_add_object(struct i915_drm_client *client,
 					      struct drm_i915_gem_object *obj)
@@ -87,6 +124,39 @@ i915_drm_client_add_context_objects(struct i915_drm_client *client,
 				    struct intel_context *ce)
 {
 }
+
+static inline void
+i915_drm_client_init_object(struct drm_i915_gem_object *obj)
+{
+}
+
+static inline int
+i915_drm_client_open_object(struct i915_drm_client *client,
+			    struct drm_i915_gem_object *obj)
+{
+	return 0;
+}
+
+static inline void
+i915_drm_client_close_object(struct i915_drm_client *client,
+			     struct drm_i915_gem_object *obj)
+{
+}
+
+static inline void
+i915_drm_client_update_object(struct drm_i915_gem_object *obj)
+{
+}
+
+static inline void
+i915_drm_client_export_object(struct drm_i915_gem_object *obj)
+{
+}
+
+static inline void
+i915_drm_client_object_active(struct drm_i915_gem_object *obj)
+{
+}
 #endif
 
 #endif /* !__I915_DRM_CLIENT_H__ */
@@ -123,14 +123,11 @@ struct i915_gem_mm {
 	spinlock_t obj_lock;
 
 	/**
-	 * List of objects which are purgeable.
-	 */
-	struct list_head purge_list;
-
-	/**
-	 * List of objects which have allocated pages and are shrinkable.
+	 * Per NUMA node lists of shrinkable objects, indexed by the node
+	 * backing each object, so that the shrinker only reclaims from the
+	 * node under memory pressure. Sized by nr_node_ids.
 	 */
-	struct list_head shrink_list;
+	struct i915_gem_shrink_node *shrink_nodes;
 
 	/**
 	 * List of objects which are pending destruction.
@@ -161,6 +158,21 @@ struct i915_gem_mm {
 	u32 shrink_count;
 };
 
+struct i915_gem_shrink_node {
+	/**
+	 * List of objects which are purgeable.
+	 */
+	struct list_head purge_list;
+
+	/**
+	 * List of objects which have allocated pages and are shrinkable.
+	 */
+	struct list_head shrink_list;
+
+	/* pages on both lists, reported to the NUMA aware shrinker */
+	unsigned long shrink_pages;
+};
+
 struct i915_virtual_gpu {
 	struct mutex lock; /* serialises sending of g2v_notify command pkts */
 	bool active;
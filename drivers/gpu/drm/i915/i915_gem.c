@@ -1074,6 +1074,7 @@ i915_gem_madvise_ioctl(struct drm_device *dev, void *data,
 		obj->mm.madv = args->madv;
 		if (obj->ops->adjust_lru)
 			obj->ops->adjust_lru(obj);
+		i915_drm_client_update_object(obj);
 	}
 
 	if (i915_gem_object_has_pages(obj) ||
@@ -1081,16 +1082,9 @@ i915_gem_madvise_ioctl(struct drm_device *dev, void *data,
 		unsigned long flags;
 
 		spin_lock_irqsave(&i915->mm.obj_lock, flags);
-		if (!list_empty(&obj->mm.link)) {
-			struct list_head *list;
-
-			if (obj->mm.madv != I915_MADV_WILLNEED)
-				list = &i915->mm.purge_list;
-			else
-				list = &i915->mm.shrink_list;
-			list_move_tail(&obj->mm.link, list);
-
-		}
+		if (!list_empty(&obj->mm.link))
+			list_move_tail(&obj->mm.link,
+				       i915_gem_object_shrink_list(obj));
 		spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 	}
 
@@ -1288,24 +1282,43 @@ void i915_gem_driver_release(struct drm_i915_private *dev_priv)
 	drm_WARN_ON(&dev_priv->drm, !list_empty(&dev_priv->gem.contexts.list));
 }
 
-static void i915_gem_init__mm(struct drm_i915_private *i915)
+static int i915_gem_init__mm(struct drm_i915_private *i915)
 {
+	int nid;
+
 	spin_lock_init(&i915->mm.obj_lock);
 
 	init_llist_head(&i915->mm.free_list);
 
-	INIT_LIST_HEAD(&i915->mm.purge_list);
-	INIT_LIST_HEAD(&i915->mm.shrink_list);
+	i915->mm.shrink_nodes = kcalloc(nr_node_ids,
+					sizeof(*i915->mm.shrink_nodes),
+					GFP_KERNEL);
+	if (!i915->mm.shrink_nodes)
+		return -ENOMEM;
+
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		INIT_LIST_HEAD(&i915->mm.shrink_nodes[nid].purge_list);
+		INIT_LIST_HEAD(&i915->mm.shrink_nodes[nid].shrink_list);
+	}
 
 	i915_gem_init__objects(i915);
+
+	return 0;
 }
 
-void i915_gem_init_early(struct drm_i915_private *dev_priv)
+int i915_gem_init_early(struct drm_i915_private *dev_priv)
 {
-	i915_gem_init__mm(dev_priv);
+	int ret;
+
+	ret = i915_gem_init__mm(dev_priv);
+	if (ret)
+		return ret;
+
 	i915_gem_init__contexts(dev_priv);
 
 	spin_lock_init(&dev_priv->frontbuffer_lock);
+
+	return 0;
 }
 
 void i915_gem_cleanup_early(struct drm_i915_private *dev_priv)
@@ -1314,6 +1327,7 @@ void i915_gem_cleanup_early(struct drm_i915_private *dev_priv)
 	GEM_BUG_ON(!llist_empty(&dev_priv->mm.free_list));
 	GEM_BUG_ON(atomic_read(&dev_priv->mm.free_count));
 	drm_WARN_ON(&dev_priv->drm, dev_priv->mm.shrink_count);
+	kfree(dev_priv->mm.shrink_nodes);
 }
 
 int i915_gem_open(struct drm_i915_private *i915, struct drm_file *file)
@@ -46,7 +46,7 @@ struct i915_vma;
 	 I915_GEM_DOMAIN_INSTRUCTION | \
 	 I915_GEM_DOMAIN_VERTEX)
 
-void i915_gem_init_early(struct drm_i915_private *i915);
+int i915_gem_init_early(struct drm_i915_private *i915);
 void i915_gem_cleanup_early(struct drm_i915_private *i915);
 
 void i915_gem_drain_freed_objects(struct drm_i915_private *i915);
@@ -1292,6 +1292,7 @@ static void engine_record_registers(struct intel_engine_coredump *ee)
 {
 	const struct intel_engine_cs *engine = ee->engine;
 	struct drm_i915_private *i915 = engine->i915;
+	const u32 base = engine->mmio_base;
 
 	if (IS_SRIOV_VF(i915))
 		return;
@@ -1321,18 +1322,33 @@ static void engine_record_registers(struct intel_engine_coredump *ee)
 	}
 
 	if (GRAPHICS_VER(i915) >= 4) {
-		ee->esr = ENGINE_READ(engine, RING_ESR);
-		ee->faddr = ENGINE_READ(engine, RING_DMA_FADD);
-		ee->ipeir = ENGINE_READ(engine, RING_IPEIR);
-		ee->ipehr = ENGINE_READ(engine, RING_IPEHR);
-		ee->instps = ENGINE_READ(engine, RING_INSTPS);
-		ee->bbaddr = ENGINE_READ(engine, RING_BBADDR);
-		ee->ccid = ENGINE_READ(engine, CCID);
-		if (GRAPHICS_VER(i915) >= 8) {
-			ee->faddr |= (u64)ENGINE_READ(engine, RING_DMA_FADD_UDW) << 32;
-			ee->bbaddr |= (u64)ENGINE_READ(engine, RING_BBADDR_UDW) << 32;
-		}
-		ee->bbstate = ENGINE_READ(engine, RING_BBSTATE);
+		const i915_reg_t regs[] = {
+			RING_ESR(base),
+			RING_DMA_FADD(base),
+			RING_IPEIR(base),
+			RING_IPEHR(base),
+			RING_INSTPS(base),
+			RING_BBADDR(base),
+			CCID(base),
+			RING_BBSTATE(base),
+			/* gen8+ */
+			RING_DMA_FADD_UDW(base),
+			RING_BBADDR_UDW(base),
+		};
+		u32 val[ARRAY_SIZE(regs)] = {};
+
+		intel_uncore_read_many(engine->uncore, regs, val,
+				       GRAPHICS_VER(i915) >= 8 ?
+				       ARRAY_SIZE(regs) : ARRAY_SIZE(regs) - 2);
+
+		ee->esr = val[0];
+		ee->faddr = (u64)val[8] << 32 | val[1];
+		ee->ipeir = val[2];
+		ee->ipehr = val[3];
+		ee->instps = val[4];
+		ee->bbaddr = (u64)val[9] << 32 | val[5];
+		ee->ccid = val[6];
+		ee->bbstate = val[7];
 	} else {
 		ee->faddr = ENGINE_READ(engine, DMA_FADD_I8XX);
 		ee->ipeir = ENGINE_READ(engine, IPEIR);
@@ -1340,25 +1356,56 @@ static void engine_record_registers(struct intel_engine_coredump *ee)
 	}
 
 	if (GRAPHICS_VER(i915) >= 11) {
-		ee->cmd_cctl = ENGINE_READ(engine, RING_CMD_CCTL);
-		ee->cscmdop = ENGINE_READ(engine, RING_CSCMDOP);
-		ee->ctx_sr_ctl = ENGINE_READ(engine, RING_CTX_SR_CTL);
-		ee->dma_faddr_hi = ENGINE_READ(engine, RING_DMA_FADD_UDW);
-		ee->dma_faddr_lo = ENGINE_READ(engine, RING_DMA_FADD);
-		ee->nopid = ENGINE_READ(engine, RING_NOPID);
-		ee->excc = ENGINE_READ(engine, RING_EXCC);
+		const i915_reg_t regs[] = {
+			RING_CMD_CCTL(base),
+			RING_CSCMDOP(base),
+			RING_CTX_SR_CTL(base),
+			RING_DMA_FADD_UDW(base),
+			RING_DMA_FADD(base),
+			RING_NOPID(base),
+			RING_EXCC(base),
+		};
+		u32 val[ARRAY_SIZE(regs)];
+
+		intel_uncore_read_many(engine->uncore, regs, val,
+				       ARRAY_SIZE(regs));
+
+		ee->cmd_cctl = val[0];
+		ee->cscmdop = val[1];
+		ee->ctx_sr_ctl = val[2];
+		ee->dma_faddr_hi = val[3];
+		ee->dma_faddr_lo = val[4];
+		ee->nopid = val[5];
+		ee->excc = val[6];
 	}
 
 	intel_engine_get_instdone(engine, &ee->instdone);
 
-	ee->instpm = ENGINE_READ(engine, RING_INSTPM);
 	ee->acthd = intel_engine_get_active_head(engine);
-	ee->start = ENGINE_READ(engine, RING_START);
-	ee->head = ENGINE_READ(engine, RING_HEAD);
-	ee->tail = ENGINE_READ(engine, RING_TAIL);
-	ee->ctl = ENGINE_READ(engine, RING_CTL);
-	if (GRAPHICS_VER(i915) > 2)
-		ee->mode = ENGINE_READ(engine, RING_MI_MODE);
+	{
+		const i915_reg_t regs[] = {
+			RING_INSTPM(base),
+			RING_START(base),
+			RING_HEAD(base),
+			RING_TAIL(base),
+			RING_CTL(base),
+			/* gen3+ */
+			RING_MI_MODE(base),
+		};
+		u32 val[ARRAY_SIZE(regs)] = {};
+
+		intel_uncore_read_many(engine->uncore, regs, val,
+				       GRAPHICS_VER(i915) > 2 ?
+				       ARRAY_SIZE(regs) : ARRAY_SIZE(regs) - 1);
+
+		ee->instpm = val[0];
+		ee->start = val[1];
+		ee->head = val[2];
+		ee->tail = val[3];
+		ee->ctl = val[4];
+		if (GRAPHICS_VER(i915) > 2)
+			ee->mode = val[5];
+	}
 
 	if (!HWS_NEEDS_PHYSICAL(i915)) {
 		i915_reg_t mmio;
@@ -1405,17 +1452,20 @@ static void engine_record_registers(struct intel_engine_coredump *ee)
 			ee->vm_info.pp_dir_base =
 				ENGINE_READ(engine, RING_PP_DIR_BASE);
 		} else if (GRAPHICS_VER(i915) >= 8) {
-			u32 base = engine->mmio_base;
+			i915_reg_t regs[2 * ARRAY_SIZE(ee->vm_info.pdp)];
+			u32 val[ARRAY_SIZE(regs)];
 
-			for (i = 0; i < 4; i++) {
-				ee->vm_info.pdp[i] =
-					intel_uncore_read(engine->uncore,
-							  GEN8_RING_PDP_UDW(base, i));
-				ee->vm_info.pdp[i] <<= 32;
-				ee->vm_info.pdp[i] |=
-					intel_uncore_read(engine->uncore,
-							  GEN8_RING_PDP_LDW(base, i));
+			for (i = 0; i < ARRAY_SIZE(ee->vm_info.pdp); i++) {
+				regs[2 * i + 0] = GEN8_RING_PDP_UDW(base, i);
+				regs[2 * i + 1] = GEN8_RING_PDP_LDW(base, i);
 			}
+
+			intel_uncore_read_many(engine->uncore, regs, val,
+					       ARRAY_SIZE(regs));
+
+			for (i = 0; i < ARRAY_SIZE(ee->vm_info.pdp); i++)
+				ee->vm_info.pdp[i] =
+					(u64)val[2 * i + 0] << 32 | val[2 * i + 1];
 		}
 	}
 }
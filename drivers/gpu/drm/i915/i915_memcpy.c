@@ -27,6 +27,7 @@
 #include <linux/cpufeature.h>
 #include <linux/bug.h>
 #include <linux/build_bug.h>
+#include <linux/sizes.h>
 #include <asm/fpu/api.h>
 
 #include "i915_memcpy.h"
@@ -38,6 +39,25 @@
 #endif
 
 static DEFINE_STATIC_KEY_FALSE(has_movntdqa);
+static DEFINE_STATIC_KEY_FALSE(has_movntdqa_avx2);
+static DEFINE_STATIC_KEY_FALSE(has_movntdqa_avx512);
+
+/*
+ * The wide variants only pay off once the transfer is large enough to
+ * amortise the extra alignment prologue; for AVX-512 we additionally
+ * want to avoid the frequency licence transition for small copies, so
+ * only switch to zmm streaming loads for a page or more. Lengths are in
+ * units of 16 bytes, matching the inner loops.
+ */
+#define WC_AVX2_MIN_LEN		(SZ_256 >> 4)
+#define WC_AVX512_MIN_LEN	(SZ_4K >> 4)
+
+/*
+ * kernel_fpu_begin() disables preemption, so for large transfers (e.g.
+ * reading back LMEM through the aperture) periodically release the FPU
+ * to provide a preemption point between batches.
+ */
+#define WC_FPU_BATCH		SZ_64K
 
 static void __memcpy_ntdqa(void *dst, const void *src, unsigned long len)
 {
@@ -97,6 +117,119 @@ static void __memcpy_ntdqu(void *dst, const void *src, unsigned long len)
 	kernel_fpu_end();
 }
 
+static void __memcpy_ntdqa_avx2(void *dst, const void *src, unsigned long len)
+{
+	unsigned long done = 0;
+
+	kernel_fpu_begin();
+
+	/* vmovntdqa %ymm requires a 32-byte aligned source */
+	if ((unsigned long)src & 16) {
+		asm("vmovntdqa (%0), %%xmm0\n"
+		    "vmovdqu %%xmm0, (%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 16;
+		dst += 16;
+		len--;
+	}
+
+	while (len >= 8) {
+		asm("vmovntdqa   (%0), %%ymm0\n"
+		    "vmovntdqa 32(%0), %%ymm1\n"
+		    "vmovntdqa 64(%0), %%ymm2\n"
+		    "vmovntdqa 96(%0), %%ymm3\n"
+		    "vmovdqu %%ymm0,   (%1)\n"
+		    "vmovdqu %%ymm1, 32(%1)\n"
+		    "vmovdqu %%ymm2, 64(%1)\n"
+		    "vmovdqu %%ymm3, 96(%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 128;
+		dst += 128;
+		len -= 8;
+
+		done += 128;
+		if (IS_ALIGNED(done, WC_FPU_BATCH) && len) {
+			asm volatile("vzeroupper");
+			kernel_fpu_end();
+			kernel_fpu_begin();
+		}
+	}
+	while (len--) {
+		asm("vmovntdqa (%0), %%xmm0\n"
+		    "vmovdqu %%xmm0, (%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 16;
+		dst += 16;
+	}
+
+	asm volatile("vzeroupper");
+	kernel_fpu_end();
+}
+
+static void __memcpy_ntdqa_avx512(void *dst, const void *src, unsigned long len)
+{
+	unsigned long done = 0;
+
+	kernel_fpu_begin();
+
+	/* vmovntdqa %zmm requires a 64-byte aligned source */
+	while ((unsigned long)src & 63) {
+		asm("vmovntdqa (%0), %%xmm0\n"
+		    "vmovdqu %%xmm0, (%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 16;
+		dst += 16;
+		len--;
+	}
+
+	while (len >= 16) {
+		asm("vmovntdqa    (%0), %%zmm0\n"
+		    "vmovntdqa  64(%0), %%zmm1\n"
+		    "vmovntdqa 128(%0), %%zmm2\n"
+		    "vmovntdqa 192(%0), %%zmm3\n"
+		    "vmovdqu64 %%zmm0,    (%1)\n"
+		    "vmovdqu64 %%zmm1,  64(%1)\n"
+		    "vmovdqu64 %%zmm2, 128(%1)\n"
+		    "vmovdqu64 %%zmm3, 192(%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 256;
+		dst += 256;
+		len -= 16;
+
+		done += 256;
+		if (IS_ALIGNED(done, WC_FPU_BATCH) && len) {
+			asm volatile("vzeroupper");
+			kernel_fpu_end();
+			kernel_fpu_begin();
+		}
+	}
+	while (len--) {
+		asm("vmovntdqa (%0), %%xmm0\n"
+		    "vmovdqu %%xmm0, (%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 16;
+		dst += 16;
+	}
+
+	asm volatile("vzeroupper");
+	kernel_fpu_end();
+}
+
+static void __memcpy_from_wc(void *dst, const void *src, unsigned long len,
+			     bool aligned)
+{
+	if (static_branch_unlikely(&has_movntdqa_avx512) &&
+	    len >= WC_AVX512_MIN_LEN)
+		__memcpy_ntdqa_avx512(dst, src, len);
+	else if (static_branch_unlikely(&has_movntdqa_avx2) &&
+		 len >= WC_AVX2_MIN_LEN)
+		__memcpy_ntdqa_avx2(dst, src, len);
+	else if (aligned)
+		__memcpy_ntdqa(dst, src, len);
+	else
+		__memcpy_ntdqu(dst, src, len);
+}
+
 /**
  * i915_memcpy_from_wc: perform an accelerated *aligned* read from WC
  * @dst: destination pointer
@@ -104,7 +237,9 @@ static void __memcpy_ntdqu(void *dst, const void *src, unsigned long len)
  * @len: how many bytes to copy
  *
  * i915_memcpy_from_wc copies @len bytes from @src to @dst using
- * non-temporal instructions where available. Note that all arguments
+ * non-temporal instructions where available, using the widest streaming
+ * load (SSE4.1, AVX2 or AVX-512) supported by the CPU for the size of the
+ * transfer. Note that all arguments
  * (@src, @dst) must be aligned to 16 bytes and @len must be a multiple
  * of 16.
  *
@@ -121,7 +256,7 @@ bool i915_memcpy_from_wc(void *dst, const void *src, unsigned long len)
 
 	if (static_branch_likely(&has_movntdqa)) {
 		if (likely(len))
-			__memcpy_ntdqa(dst, src, len >> 4);
+			__memcpy_from_wc(dst, src, len >> 4, true);
 		return true;
 	}
 
@@ -157,7 +292,7 @@ void i915_unaligned_memcpy_from_wc(void *dst, const void *src, unsigned long len
 	}
 
 	if (likely(len))
-		__memcpy_ntdqu(dst, src, DIV_ROUND_UP(len, 16));
+		__memcpy_from_wc(dst, src, DIV_ROUND_UP(len, 16), false);
 }
 
 void i915_memcpy_init_early(struct drm_i915_private *dev_priv)
@@ -166,7 +301,19 @@ void i915_memcpy_init_early(struct drm_i915_private *dev_priv)
 	 * Some hypervisors (e.g. KVM) don't support VEX-prefix instructions
 	 * emulation. So don't enable movntdqa in hypervisor guest.
 	 */
-	if (static_cpu_has(X86_FEATURE_XMM4_1) &&
-	    !boot_cpu_has(X86_FEATURE_HYPERVISOR))
-		static_branch_enable(&has_movntdqa);
+	if (!static_cpu_has(X86_FEATURE_XMM4_1) ||
+	    boot_cpu_has(X86_FEATURE_HYPERVISOR))
+		return;
+
+	static_branch_enable(&has_movntdqa);
+
+	/* 256b vmovntdqa was only introduced with AVX2 */
+	if (boot_cpu_has(X86_FEATURE_AVX2) &&
+	    cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM, NULL))
+		static_branch_enable(&has_movntdqa_avx2);
+
+	if (boot_cpu_has(X86_FEATURE_AVX512F) &&
+	    cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM |
+			      XFEATURE_MASK_AVX512, NULL))
+		static_branch_enable(&has_movntdqa_avx512);
 }
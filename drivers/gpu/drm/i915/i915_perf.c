@@ -704,6 +704,56 @@ static int append_oa_sample(struct i915_perf_stream *stream,
 	return 0;
 }
 
+/*
+ * Consumed reports must have their report id and timestamp cleared (or be
+ * zeroed entirely for non power of 2 sizes) so that
+ * oa_buffer_check_unlocked() can detect reports that have not landed yet.
+ */
+static void gen8_oa_report_clear(struct i915_perf_stream *stream, u8 *report)
+{
+	int report_size = stream->oa_buffer.format->size;
+	u32 *report32 = (void *)report;
+
+	if (is_power_of_2(report_size)) {
+		oa_report_id_clear(stream, report32);
+		oa_timestamp_clear(stream, report32);
+	} else {
+		u8 *oa_buf_end = stream->oa_buffer.vaddr + OA_BUFFER_SIZE;
+		u32 part = oa_buf_end - report;
+
+		/* Zero out the entire report */
+		if (report_size <= part) {
+			memset(report, 0, report_size);
+		} else {
+			memset(report, 0, part);
+			memset(stream->oa_buffer.vaddr, 0, report_size - part);
+		}
+	}
+}
+
+static void gen8_oa_head_write(struct i915_perf_stream *stream, u32 head)
+{
+	u32 gtt_offset = i915_ggtt_offset(stream->oa_buffer.vma);
+	i915_reg_t oaheadptr;
+	unsigned long flags;
+
+	oaheadptr = GRAPHICS_VER(stream->perf->i915) == 12 ?
+		    __oa_regs(stream)->oa_head_ptr :
+		    GEN8_OAHEADPTR;
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+
+	/*
+	 * We index relative to oa_buf_base while consuming reports so put
+	 * back the gtt_offset here...
+	 */
+	intel_uncore_write(stream->uncore, oaheadptr,
+			   (head + gtt_offset) & GEN12_OAG_OAHEADPTR_MASK);
+	stream->oa_buffer.head = head;
+
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+}
+
 /**
  * gen8_append_oa_reports - Copies all buffered OA reports into
  *			    userspace read() buffer.
@@ -733,7 +783,6 @@ static int gen8_append_oa_reports(struct i915_perf_stream *stream,
 	struct intel_uncore *uncore = stream->uncore;
 	int report_size = stream->oa_buffer.format->size;
 	u8 *oa_buf_base = stream->oa_buffer.vaddr;
-	u32 gtt_offset = i915_ggtt_offset(stream->oa_buffer.vma);
 	u32 mask = (OA_BUFFER_SIZE - 1);
 	size_t start_offset = *offset;
 	unsigned long flags;
@@ -879,49 +928,48 @@ static int gen8_append_oa_reports(struct i915_perf_stream *stream,
 			stream->oa_buffer.last_ctx_id = ctx_id;
 		}
 
-		if (is_power_of_2(report_size)) {
-			/*
-			 * Clear out the report id and timestamp as a means
-			 * to detect unlanded reports.
-			 */
-			oa_report_id_clear(stream, report32);
-			oa_timestamp_clear(stream, report32);
-		} else {
-			u8 *oa_buf_end = stream->oa_buffer.vaddr +
-					 OA_BUFFER_SIZE;
-			u32 part = oa_buf_end - (u8 *)report32;
-
-			/* Zero out the entire report */
-			if (report_size <= part) {
-				memset(report32, 0, report_size);
-			} else {
-				memset(report32, 0, part);
-				memset(oa_buf_base, 0, report_size - part);
-			}
-		}
+		gen8_oa_report_clear(stream, report);
 	}
 
-	if (start_offset != *offset) {
-		i915_reg_t oaheadptr;
+	if (start_offset != *offset)
+		gen8_oa_head_write(stream, head);
 
-		oaheadptr = GRAPHICS_VER(stream->perf->i915) == 12 ?
-			    __oa_regs(stream)->oa_head_ptr :
-			    GEN8_OAHEADPTR;
+	return ret;
+}
 
-		spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+static i915_reg_t gen8_oa_status_reg(struct i915_perf_stream *stream)
+{
+	return GRAPHICS_VER(stream->perf->i915) == 12 ?
+	       __oa_regs(stream)->oa_status :
+	       GEN8_OASTATUS;
+}
 
-		/*
-		 * We removed the gtt_offset for the copy loop above, indexing
-		 * relative to oa_buf_base so put back here...
-		 */
-		intel_uncore_write(uncore, oaheadptr,
-				   (head + gtt_offset) & GEN12_OAG_OAHEADPTR_MASK);
-		stream->oa_buffer.head = head;
+static u32 gen8_oa_overflow_restart(struct i915_perf_stream *stream)
+{
+	drm_dbg(&stream->perf->i915->drm,
+		"OA buffer overflow (exponent = %d): force restart\n",
+		stream->period_exponent);
 
-		spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
-	}
+	stream->perf->ops.oa_disable(stream);
+	stream->perf->ops.oa_enable(stream);
 
-	return ret;
+	/*
+	 * Note: .oa_enable() is expected to re-init the oabuffer and
+	 * reset GEN8_OASTATUS for us
+	 */
+	return intel_uncore_read(stream->uncore, gen8_oa_status_reg(stream));
+}
+
+static void gen8_oa_report_lost_clear(struct i915_perf_stream *stream)
+{
+	struct intel_uncore *uncore = stream->uncore;
+
+	intel_uncore_rmw(uncore, gen8_oa_status_reg(stream),
+			 GEN8_OASTATUS_COUNTER_OVERFLOW |
+			 GEN8_OASTATUS_REPORT_LOST,
+			 IS_GRAPHICS_VER(uncore->i915, 8, 11) ?
+			 (GEN8_OASTATUS_HEAD_POINTER_WRAP |
+			  GEN8_OASTATUS_TAIL_POINTER_WRAP) : 0);
 }
 
 /**
@@ -951,17 +999,12 @@ static int gen8_oa_read(struct i915_perf_stream *stream,
 {
 	struct intel_uncore *uncore = stream->uncore;
 	u32 oastatus;
-	i915_reg_t oastatus_reg;
 	int ret;
 
 	if (drm_WARN_ON(&uncore->i915->drm, !stream->oa_buffer.vaddr))
 		return -EIO;
 
-	oastatus_reg = GRAPHICS_VER(stream->perf->i915) == 12 ?
-		       __oa_regs(stream)->oa_status :
-		       GEN8_OASTATUS;
-
-	oastatus = intel_uncore_read(uncore, oastatus_reg);
+	oastatus = intel_uncore_read(uncore, gen8_oa_status_reg(stream));
 
 	/*
 	 * We treat OABUFFER_OVERFLOW as a significant error:
@@ -983,18 +1026,7 @@ static int gen8_oa_read(struct i915_perf_stream *stream,
 		if (ret)
 			return ret;
 
-		drm_dbg(&stream->perf->i915->drm,
-			"OA buffer overflow (exponent = %d): force restart\n",
-			stream->period_exponent);
-
-		stream->perf->ops.oa_disable(stream);
-		stream->perf->ops.oa_enable(stream);
-
-		/*
-		 * Note: .oa_enable() is expected to re-init the oabuffer and
-		 * reset GEN8_OASTATUS for us
-		 */
-		oastatus = intel_uncore_read(uncore, oastatus_reg);
+		oastatus = gen8_oa_overflow_restart(stream);
 	}
 
 	if (oastatus & GEN8_OASTATUS_REPORT_LOST) {
@@ -1003,17 +1035,86 @@ static int gen8_oa_read(struct i915_perf_stream *stream,
 		if (ret)
 			return ret;
 
-		intel_uncore_rmw(uncore, oastatus_reg,
-				 GEN8_OASTATUS_COUNTER_OVERFLOW |
-				 GEN8_OASTATUS_REPORT_LOST,
-				 IS_GRAPHICS_VER(uncore->i915, 8, 11) ?
-				 (GEN8_OASTATUS_HEAD_POINTER_WRAP |
-				  GEN8_OASTATUS_TAIL_POINTER_WRAP) : 0);
+		gen8_oa_report_lost_clear(stream);
 	}
 
 	return gen8_append_oa_reports(stream, buf, count, offset);
 }
 
+/**
+ * gen8_oa_sync - hand consumed OA buffer space back to the OA unit
+ * @stream: An i915-perf stream opened for OA metrics and mmapped
+ * @sync: (inout): the head consumed by userspace, returns the new tail
+ *
+ * The mmapped counterpart of gen8_oa_read(): instead of copying reports and
+ * status records to userspace, the reports userspace has parsed in place are
+ * cleared for the unlanded report detection, the head is advanced and the
+ * OA status is returned as flags.
+ *
+ * Note: unlike read(), no reports are filtered or squashed here so this is
+ * only available to perfmon capable callers for context filtered streams.
+ *
+ * Returns: zero on success or a negative error code
+ */
+static int gen8_oa_sync(struct i915_perf_stream *stream,
+			struct drm_i915_perf_oa_sync *sync)
+{
+	int report_size = stream->oa_buffer.format->size;
+	u32 mask = (OA_BUFFER_SIZE - 1);
+	unsigned long flags;
+	u32 head, tail;
+	u32 oastatus;
+
+	if (!stream->enabled)
+		return -EIO;
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+
+	head = stream->oa_buffer.head;
+	tail = stream->oa_buffer.tail;
+
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+
+	/* Userspace may only consume whole reports that we have validated */
+	if (sync->head >= OA_BUFFER_SIZE ||
+	    OA_TAKEN(sync->head, head) > OA_TAKEN(tail, head) ||
+	    OA_TAKEN(sync->head, head) % report_size)
+		return -EINVAL;
+
+	if (sync->head != head) {
+		for (/* none */;
+		     head != sync->head;
+		     head = (head + report_size) & mask)
+			gen8_oa_report_clear(stream, stream->oa_buffer.vaddr + head);
+
+		gen8_oa_head_write(stream, head);
+	}
+
+	sync->flags = 0;
+	oastatus = intel_uncore_read(stream->uncore, gen8_oa_status_reg(stream));
+	if (oastatus & GEN8_OASTATUS_OABUFFER_OVERFLOW) {
+		sync->flags |= I915_PERF_OA_SYNC_BUFFER_LOST;
+		oastatus = gen8_oa_overflow_restart(stream);
+	}
+	if (oastatus & GEN8_OASTATUS_REPORT_LOST) {
+		sync->flags |= I915_PERF_OA_SYNC_REPORT_LOST;
+		gen8_oa_report_lost_clear(stream);
+	}
+
+	oa_buffer_check_unlocked(stream);
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+
+	sync->head = stream->oa_buffer.head;
+	sync->tail = stream->oa_buffer.tail;
+
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+
+	sync->size = OA_BUFFER_SIZE;
+
+	return 0;
+}
+
 /**
  * gen7_append_oa_reports - Copies all buffered OA reports into
  *			    userspace read() buffer.
@@ -3431,6 +3532,24 @@ void i915_oa_init_reg_state(const struct intel_context *ce,
  *
  * Returns: The number of bytes copied or a negative error code on failure.
  */
+static int __i915_perf_read(struct i915_perf_stream *stream,
+			    char __user *buf,
+			    size_t count,
+			    size_t *offset)
+{
+	int ret;
+
+	mutex_lock(&stream->lock);
+	/* The buffer may have been mapped since we last looked */
+	if (atomic_read(&stream->oa_buffer.mmapped))
+		ret = -EBUSY;
+	else
+		ret = stream->ops->read(stream, buf, count, offset);
+	mutex_unlock(&stream->lock);
+
+	return ret;
+}
+
 static ssize_t i915_perf_read(struct file *file,
 			      char __user *buf,
 			      size_t count,
@@ -3447,6 +3566,10 @@ static ssize_t i915_perf_read(struct file *file,
 	if (!stream->enabled || !(stream->sample_flags & SAMPLE_OA_REPORT))
 		return -EIO;
 
+	/* Reports are consumed in place, see i915_perf_mmap() */
+	if (atomic_read(&stream->oa_buffer.mmapped))
+		return -EBUSY;
+
 	if (!(file->f_flags & O_NONBLOCK)) {
 		/* There's the small chance of false positives from
 		 * stream->ops->wait_unlocked.
@@ -3460,14 +3583,10 @@ static ssize_t i915_perf_read(struct file *file,
 			if (ret)
 				return ret;
 
-			mutex_lock(&stream->lock);
-			ret = stream->ops->read(stream, buf, count, &offset);
-			mutex_unlock(&stream->lock);
+			ret = __i915_perf_read(stream, buf, count, &offset);
 		} while (!offset && !ret);
 	} else {
-		mutex_lock(&stream->lock);
-		ret = stream->ops->read(stream, buf, count, &offset);
-		mutex_unlock(&stream->lock);
+		ret = __i915_perf_read(stream, buf, count, &offset);
 	}
 
 	/* We allow the poll checking to sometimes report false positive EPOLLIN
@@ -3649,6 +3768,29 @@ static long i915_perf_config_locked(struct i915_perf_stream *stream,
 	return ret;
 }
 
+static long i915_perf_oa_sync_locked(struct i915_perf_stream *stream,
+				     unsigned long arg)
+{
+	struct drm_i915_perf_oa_sync __user *usync = (void __user *)arg;
+	struct drm_i915_perf_oa_sync sync;
+	int err;
+
+	if (!atomic_read(&stream->oa_buffer.mmapped))
+		return -EINVAL;
+
+	if (copy_from_user(&sync, usync, sizeof(sync)))
+		return -EFAULT;
+
+	err = gen8_oa_sync(stream, &sync);
+	if (err)
+		return err;
+
+	if (copy_to_user(usync, &sync, sizeof(sync)))
+		return -EFAULT;
+
+	return 0;
+}
+
 /**
  * i915_perf_ioctl_locked - support ioctl() usage with i915 perf stream FDs
  * @stream: An i915 perf stream
@@ -3671,6 +3813,8 @@ static long i915_perf_ioctl_locked(struct i915_perf_stream *stream,
 		return 0;
 	case I915_PERF_IOCTL_CONFIG:
 		return i915_perf_config_locked(stream, arg);
+	case I915_PERF_IOCTL_OA_SYNC:
+		return i915_perf_oa_sync_locked(stream, arg);
 	}
 
 	return -EINVAL;
@@ -3758,14 +3902,108 @@ static int i915_perf_release(struct inode *inode, struct file *file)
 }
 
 
+/*
+ * The mapping count is maintained without stream->lock: the lock is held
+ * around copy_to_user() by read() and I915_PERF_IOCTL_OA_SYNC, and so nests
+ * outside of the mmap_lock that is held when the vm_ops are called.
+ */
+static void i915_perf_vm_open(struct vm_area_struct *vma)
+{
+	struct i915_perf_stream *stream = vma->vm_private_data;
+
+	atomic_inc(&stream->oa_buffer.mmapped);
+}
+
+static void i915_perf_vm_close(struct vm_area_struct *vma)
+{
+	struct i915_perf_stream *stream = vma->vm_private_data;
+
+	atomic_dec(&stream->oa_buffer.mmapped);
+}
+
+static const struct vm_operations_struct i915_perf_vm_ops = {
+	.open = i915_perf_vm_open,
+	.close = i915_perf_vm_close,
+};
+
+/**
+ * i915_perf_mmap - map the OA buffer of a stream read-only into userspace
+ * @file: An i915 perf stream file
+ * @vma: the userspace mapping covering the whole OA buffer
+ *
+ * Lets userspace parse OA reports in place rather than having every report
+ * copied out by read(). Once mapped, read() is refused and the stream is
+ * driven with poll() and I915_PERF_IOCTL_OA_SYNC.
+ *
+ * Returns: zero on success or a negative error code
+ */
+static int i915_perf_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct i915_perf_stream *stream = file->private_data;
+	struct drm_i915_gem_object *obj;
+	unsigned long start = vma->vm_start;
+	struct sgt_iter iter;
+	struct page *page;
+	int ret;
+
+	if (!(stream->sample_flags & SAMPLE_OA_REPORT) ||
+	    stream->perf->ops.read != gen8_oa_read)
+		return -ENODEV;
+
+	/*
+	 * read() squashes the context IDs of other contexts for a context
+	 * filtered stream, a mapping exposes the raw reports.
+	 */
+	if (stream->ctx && i915_perf_stream_paranoid && !perfmon_capable()) {
+		drm_dbg(&stream->perf->i915->drm,
+			"Insufficient privilege to map a context filtered OA buffer\n");
+		return -EACCES;
+	}
+
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != OA_BUFFER_SIZE)
+		return -EINVAL;
+
+	/* Only the kernel may clear reports and move the head */
+	if (vma->vm_flags & (VM_WRITE | VM_EXEC))
+		return -EINVAL;
+
+	vm_flags_mod(vma, VM_DONTEXPAND | VM_DONTDUMP | VM_DONTCOPY,
+		     VM_MAYWRITE | VM_MAYEXEC);
+
+	/*
+	 * Refuse read() before the reports become visible through the
+	 * mapping; the count is dropped again as the last mapping is closed,
+	 * after which read() may resume. A failed mmap is never closed.
+	 */
+	vma->vm_ops = &i915_perf_vm_ops;
+	vma->vm_private_data = stream;
+	atomic_inc(&stream->oa_buffer.mmapped);
+
+	/* The pages stay pinned by the kernel map until the stream is destroyed */
+	obj = stream->oa_buffer.vma->obj;
+	for_each_sgt_page(page, iter, obj->mm.pages) {
+		ret = remap_pfn_range(vma, start, page_to_pfn(page),
+				      PAGE_SIZE, vma->vm_page_prot);
+		if (ret) {
+			atomic_dec(&stream->oa_buffer.mmapped);
+			return ret;
+		}
+
+		start += PAGE_SIZE;
+	}
+
+	return 0;
+}
+
 static const struct file_operations fops = {
 	.owner		= THIS_MODULE,
 	.release	= i915_perf_release,
 	.poll		= i915_perf_poll,
 	.read		= i915_perf_read,
+	.mmap		= i915_perf_mmap,
 	.unlocked_ioctl	= i915_perf_ioctl,
-	/* Our ioctl have no arguments, so it's safe to use the same function
-	 * to handle 32bits compatibility.
+	/* Our ioctl arguments are either scalars or made of __u32 fields, so
+	 * it's safe to use the same function to handle 32bits compatibility.
 	 */
 	.compat_ioctl   = i915_perf_ioctl,
 };
@@ -5253,6 +5491,9 @@ int i915_perf_ioctl_version(struct drm_i915_private *i915)
 	 *    DRM_I915_PERF_PROP_OA_ENGINE_INSTANCE
 	 *
 	 * 7: Add support for video decode and enhancement classes.
+	 *
+	 * 8: Add mmap() of the OA buffer and I915_PERF_IOCTL_OA_SYNC to
+	 *    consume the mapped reports in place.
 	 */
 
 	/*
@@ -5264,7 +5505,7 @@ int i915_perf_ioctl_version(struct drm_i915_private *i915)
 	    intel_check_bios_c6_setup(&i915->media_gt->rc6))
 		return 6;
 
-	return 7;
+	return 8;
 }
 
 #if IS_ENABLED(CONFIG_DRM_I915_SELFTEST)
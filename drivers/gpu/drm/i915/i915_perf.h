@@ -11,6 +11,29 @@
 
 #include "i915_perf_types.h"
 
+/*
+ * Zero-copy access to the OA buffer: after mmap()ing the stream fd userspace
+ * parses reports in place and hands consumed space back to the OA unit with
+ * I915_PERF_IOCTL_OA_SYNC, which also returns the next validated tail and any
+ * lost report/buffer conditions that read() would have reported as records.
+ */
+#ifndef I915_PERF_IOCTL_OA_SYNC
+struct drm_i915_perf_oa_sync {
+	/** @head: in: offset userspace has consumed up to; out: new head */
+	__u32 head;
+	/** @tail: out: offset of the last report that has fully landed */
+	__u32 tail;
+#define I915_PERF_OA_SYNC_REPORT_LOST	(1 << 0)
+#define I915_PERF_OA_SYNC_BUFFER_LOST	(1 << 1)
+	/** @flags: out: I915_PERF_OA_SYNC_* since the previous sync */
+	__u32 flags;
+	/** @size: out: size of the mapped OA buffer */
+	__u32 size;
+};
+
+#define I915_PERF_IOCTL_OA_SYNC	_IOWR('i', 0x3, struct drm_i915_perf_oa_sync)
+#endif
+
 struct drm_device;
 struct drm_file;
 struct drm_i915_private;
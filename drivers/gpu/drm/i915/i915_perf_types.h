@@ -327,6 +327,14 @@ struct i915_perf_stream {
 		 * read by userspace.
 		 */
 		u32 tail;
+
+		/**
+		 * @oa_buffer.mmapped: Number of userspace mappings of the OA
+		 * buffer. While mapped, reports are consumed in place and the
+		 * head is advanced with I915_PERF_IOCTL_OA_SYNC instead of
+		 * using read().
+		 */
+		atomic_t mmapped;
 	} oa_buffer;
 
 	/**
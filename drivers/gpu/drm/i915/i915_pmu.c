@@ -24,6 +24,8 @@
 /* Frequency for the sampling timer for events which need it. */
 #define FREQUENCY 200
 #define PERIOD max_t(u64, 10000, NSEC_PER_SEC / FREQUENCY)
+/* Longest period the sampling timer backs off to while nothing changes. */
+#define PERIOD_MAX (4 * PERIOD)
 
 #define ENGINE_SAMPLE_MASK \
 	(BIT(I915_SAMPLE_BUSY) | \
@@ -136,21 +138,27 @@ static unsigned int event_bit(struct perf_event *event)
 	return config_bit(event->attr.config);
 }
 
-static u32 frequency_enabled_mask(void)
+static u32 frequency_enabled_mask(unsigned int gt_id)
 {
-	unsigned int i;
-	u32 mask = 0;
-
-	for (i = 0; i < I915_PMU_MAX_GT; i++)
-		mask |= config_mask(__I915_PMU_ACTUAL_FREQUENCY(i)) |
-			config_mask(__I915_PMU_REQUESTED_FREQUENCY(i));
+	return config_mask(__I915_PMU_ACTUAL_FREQUENCY(gt_id)) |
+	       config_mask(__I915_PMU_REQUESTED_FREQUENCY(gt_id));
+}
 
-	return mask;
+/*
+ * With host RPS the driver picks the requested frequency itself, in
+ * intel_rps_set(), so it is accounted from there instead of sampled. Only
+ * the frequency requested by SLPC firmware has to be sampled.
+ */
+static bool requested_frequency_sampled(struct intel_gt *gt)
+{
+	return intel_uc_uses_guc_slpc(&gt->uc);
 }
 
-static bool pmu_needs_timer(struct i915_pmu *pmu)
+static bool pmu_needs_timer(struct i915_pmu *pmu, struct intel_gt *gt)
 {
 	struct drm_i915_private *i915 = pmu_to_i915(pmu);
+	struct intel_engine_cs *engine;
+	enum intel_engine_id id;
 	u32 enable;
 
 	/*
@@ -164,7 +172,10 @@ static bool pmu_needs_timer(struct i915_pmu *pmu)
 	 * Mask out all the ones which do not need the timer, or in
 	 * other words keep all the ones that could need the timer.
 	 */
-	enable &= frequency_enabled_mask() | ENGINE_SAMPLE_MASK;
+	enable &= frequency_enabled_mask(gt->info.id) | ENGINE_SAMPLE_MASK;
+
+	if (!requested_frequency_sampled(gt))
+		enable &= ~config_mask(__I915_PMU_REQUESTED_FREQUENCY(gt->info.id));
 
 	/*
 	 * Also there is software busyness tracking available we do not
@@ -173,6 +184,19 @@ static bool pmu_needs_timer(struct i915_pmu *pmu)
 	if (i915->caps.scheduler & I915_SCHEDULER_CAP_ENGINE_BUSY_STATS)
 		enable &= ~BIT(I915_SAMPLE_BUSY);
 
+	/*
+	 * Engine samplers are tracked device wide, so only keep the ones
+	 * which are enabled on at least one engine of this GT.
+	 */
+	if (enable & ENGINE_SAMPLE_MASK) {
+		u32 engines = 0;
+
+		for_each_engine(engine, gt, id)
+			engines |= engine->pmu.enable;
+
+		enable &= ~ENGINE_SAMPLE_MASK | engines;
+	}
+
 	/*
 	 * If some bits remain it means we need the sampling timer running.
 	 */
@@ -286,17 +310,98 @@ static void park_rc6(struct intel_gt *gt)
 	pmu->sleep_last[gt->info.id] = ktime_get_raw();
 }
 
-static void __i915_pmu_maybe_start_timer(struct i915_pmu *pmu)
+/*
+ * Credit the requested frequency set by host RPS for the time since it was
+ * last accounted. Nothing is accounted while the GT is parked, where the
+ * requested frequency reads as 0.
+ */
+static void __rps_req_account(struct i915_pmu *pmu, struct intel_gt *gt)
+{
+	const unsigned int gt_id = gt->info.id;
+	struct i915_pmu_timer *t = &pmu->timer[gt_id];
+	ktime_t now;
+
+	lockdep_assert_held(&pmu->lock);
+
+	if (!(pmu->unparked & BIT(gt_id)))
+		return;
+
+	now = ktime_get();
+	store_sample(pmu, gt_id, __I915_SAMPLE_FREQ_REQ,
+		     read_sample(pmu, gt_id, __I915_SAMPLE_FREQ_REQ) +
+		     (u64)t->rps_req * ktime_us_delta(now, t->rps_req_last));
+	t->rps_req_last = now;
+}
+
+/**
+ * i915_pmu_gt_rps_set - account a change of the host RPS requested frequency
+ * @gt: GT whose frequency request changed
+ * @freq: new requested frequency in MHz
+ *
+ * Called from intel_rps_set() with the new request, so the previous one is
+ * credited for exactly as long as it was in effect.
+ */
+void i915_pmu_gt_rps_set(struct intel_gt *gt, u32 freq)
+{
+	struct i915_pmu *pmu = &gt->i915->pmu;
+
+	if (!pmu->registered)
+		return;
+
+	spin_lock_irq(&pmu->lock);
+	__rps_req_account(pmu, gt);
+	pmu->timer[gt->info.id].rps_req = freq;
+	spin_unlock_irq(&pmu->lock);
+}
+
+static u64 read_rps_req(struct i915_pmu *pmu, struct intel_gt *gt)
+{
+	unsigned long flags;
+	u64 val;
+
+	spin_lock_irqsave(&pmu->lock, flags);
+	__rps_req_account(pmu, gt);
+	val = read_sample(pmu, gt->info.id, __I915_SAMPLE_FREQ_REQ);
+	spin_unlock_irqrestore(&pmu->lock, flags);
+
+	return val;
+}
+
+static void __i915_pmu_maybe_start_timer(struct i915_pmu *pmu,
+					 struct intel_gt *gt)
 {
-	if (!pmu->timer_enabled && pmu_needs_timer(pmu)) {
-		pmu->timer_enabled = true;
-		pmu->timer_last = ktime_get();
-		hrtimer_start_range_ns(&pmu->timer,
+	struct i915_pmu_timer *t = &pmu->timer[gt->info.id];
+
+	lockdep_assert_held(&pmu->lock);
+
+	/* A parked GT has nothing to sample; unparking restarts the timer. */
+	if (!(pmu->unparked & BIT(gt->info.id)))
+		return;
+
+	if (!t->enabled && pmu_needs_timer(pmu, gt)) {
+		t->enabled = true;
+		t->last = ktime_get();
+		t->period = PERIOD;
+		t->freq_act = 0;
+		t->freq_req = 0;
+		hrtimer_start_range_ns(&t->timer,
 				       ns_to_ktime(PERIOD), 0,
 				       HRTIMER_MODE_REL_PINNED);
 	}
 }
 
+static void __i915_pmu_update_timers(struct i915_pmu *pmu)
+{
+	struct drm_i915_private *i915 = pmu_to_i915(pmu);
+	struct intel_gt *gt;
+	unsigned int i;
+
+	for_each_gt(gt, i915, i) {
+		pmu->timer[i].enabled &= pmu_needs_timer(pmu, gt);
+		__i915_pmu_maybe_start_timer(pmu, gt);
+	}
+}
+
 void i915_pmu_gt_parked(struct intel_gt *gt)
 {
 	struct i915_pmu *pmu = &gt->i915->pmu;
@@ -308,13 +413,15 @@ void i915_pmu_gt_parked(struct intel_gt *gt)
 
 	park_rc6(gt);
 
+	if (!requested_frequency_sampled(gt))
+		__rps_req_account(pmu, gt);
+
 	/*
-	 * Signal sampling timer to stop if only engine events are enabled and
-	 * GPU went idle.
+	 * Signal this GT's sampling timer to stop; there is nothing to sample
+	 * while it is parked. Other GTs keep their own timers.
 	 */
 	pmu->unparked &= ~BIT(gt->info.id);
-	if (pmu->unparked == 0)
-		pmu->timer_enabled = false;
+	pmu->timer[gt->info.id].enabled = false;
 
 	spin_unlock_irq(&pmu->lock);
 }
@@ -329,12 +436,17 @@ void i915_pmu_gt_unparked(struct intel_gt *gt)
 	spin_lock_irq(&pmu->lock);
 
 	/*
-	 * Re-enable sampling timer when GPU goes active.
+	 * Re-enable this GT's sampling timer when it goes active.
 	 */
-	if (pmu->unparked == 0)
-		__i915_pmu_maybe_start_timer(pmu);
-
 	pmu->unparked |= BIT(gt->info.id);
+	__i915_pmu_maybe_start_timer(pmu, gt);
+
+	if (!requested_frequency_sampled(gt)) {
+		struct i915_pmu_timer *t = &pmu->timer[gt->info.id];
+
+		t->rps_req = intel_rps_get_requested_frequency(&gt->rps);
+		t->rps_req_last = ktime_get();
+	}
 
 	spin_unlock_irq(&pmu->lock);
 }
@@ -355,7 +467,7 @@ static bool exclusive_mmio_access(const struct drm_i915_private *i915)
 	return GRAPHICS_VER(i915) == 7;
 }
 
-static void gen3_engine_sample(struct intel_engine_cs *engine, unsigned int period_ns)
+static bool gen3_engine_sample(struct intel_engine_cs *engine, unsigned int period_ns)
 {
 	struct intel_engine_pmu *pmu = &engine->pmu;
 	bool busy;
@@ -363,7 +475,7 @@ static void gen3_engine_sample(struct intel_engine_cs *engine, unsigned int peri
 
 	val = ENGINE_READ_FW(engine, RING_CTL);
 	if (val == 0) /* powerwell off => engine idle */
-		return;
+		return false;
 
 	if (val & RING_WAIT)
 		add_sample(&pmu->sample[I915_SAMPLE_WAIT], period_ns);
@@ -372,7 +484,7 @@ static void gen3_engine_sample(struct intel_engine_cs *engine, unsigned int peri
 
 	/* No need to sample when busy stats are supported. */
 	if (intel_engine_supports_stats(engine))
-		return;
+		return val & (RING_WAIT_SEMAPHORE | RING_WAIT);
 
 	/*
 	 * While waiting on a semaphore or event, MI_MODE reports the
@@ -388,12 +500,15 @@ static void gen3_engine_sample(struct intel_engine_cs *engine, unsigned int peri
 	}
 	if (busy)
 		add_sample(&pmu->sample[I915_SAMPLE_BUSY], period_ns);
+
+	return busy;
 }
 
-static void gen2_engine_sample(struct intel_engine_cs *engine, unsigned int period_ns)
+static bool gen2_engine_sample(struct intel_engine_cs *engine, unsigned int period_ns)
 {
 	struct intel_engine_pmu *pmu = &engine->pmu;
 	u32 tail, head, acthd;
+	bool busy;
 
 	tail = ENGINE_READ_FW(engine, RING_TAIL);
 	head = ENGINE_READ_FW(engine, RING_HEAD);
@@ -402,32 +517,47 @@ static void gen2_engine_sample(struct intel_engine_cs *engine, unsigned int peri
 	if (head & HEAD_WAIT_I8XX)
 		add_sample(&pmu->sample[I915_SAMPLE_WAIT], period_ns);
 
-	if (head & HEAD_WAIT_I8XX || head != acthd ||
-	    (head & HEAD_ADDR) != (tail & TAIL_ADDR))
+	busy = head & HEAD_WAIT_I8XX || head != acthd ||
+	       (head & HEAD_ADDR) != (tail & TAIL_ADDR);
+	if (busy)
 		add_sample(&pmu->sample[I915_SAMPLE_BUSY], period_ns);
+
+	return busy;
 }
 
-static void engine_sample(struct intel_engine_cs *engine, unsigned int period_ns)
+static bool engine_sample(struct intel_engine_cs *engine, unsigned int period_ns)
 {
 	if (GRAPHICS_VER(engine->i915) >= 3)
-		gen3_engine_sample(engine, period_ns);
+		return gen3_engine_sample(engine, period_ns);
 	else
-		gen2_engine_sample(engine, period_ns);
+		return gen2_engine_sample(engine, period_ns);
 }
 
-static void
-engines_sample(struct intel_gt *gt, unsigned int period_ns)
+/*
+ * Returns true if any engine was seen busy or waiting, in which case the
+ * caller should keep sampling at the base period.
+ */
+static bool
+engines_sample(struct intel_gt *gt, unsigned int period_ns, bool backed_off)
 {
 	struct drm_i915_private *i915 = gt->i915;
 	struct intel_engine_cs *engine;
 	enum intel_engine_id id;
 	unsigned long flags;
+	bool active = false;
 
 	if ((i915->pmu.enable & ENGINE_SAMPLE_MASK) == 0)
-		return;
+		return false;
 
 	if (!intel_gt_pm_is_awake(gt))
-		return;
+		return false;
+
+	/*
+	 * The timer only backs off after a sample that saw every engine idle,
+	 * so whatever is seen now is only known for the last base period.
+	 */
+	if (backed_off)
+		period_ns = min_t(unsigned int, period_ns, PERIOD);
 
 	for_each_engine(engine, gt, id) {
 		if (!engine->pmu.enable)
@@ -438,14 +568,16 @@ engines_sample(struct intel_gt *gt, unsigned int period_ns)
 
 		if (exclusive_mmio_access(i915)) {
 			spin_lock_irqsave(&engine->uncore->lock, flags);
-			engine_sample(engine, period_ns);
+			active |= engine_sample(engine, period_ns);
 			spin_unlock_irqrestore(&engine->uncore->lock, flags);
 		} else {
-			engine_sample(engine, period_ns);
+			active |= engine_sample(engine, period_ns);
 		}
 
 		intel_engine_pm_put_async(engine);
 	}
+
+	return active;
 }
 
 static bool
@@ -456,22 +588,47 @@ frequency_sampling_enabled(struct i915_pmu *pmu, unsigned int gt)
 		config_mask(__I915_PMU_REQUESTED_FREQUENCY(gt)));
 }
 
+/*
+ * While backed off, the previous invocation saw the same value as the one
+ * before it, so a new value is only known to have been in effect for the
+ * last base period. Credit the rest of the interval to the last known value.
+ */
 static void
-frequency_sample(struct intel_gt *gt, unsigned int period_ns)
+add_freq_sample(struct i915_pmu *pmu, unsigned int gt_id, int sample,
+		u32 last, u32 val, unsigned int period_ns, bool backed_off)
+{
+	if (backed_off && last && val != last && period_ns > PERIOD) {
+		add_sample_mult(pmu, gt_id, sample,
+				last, (period_ns - PERIOD) / 1000);
+		period_ns = PERIOD;
+	}
+
+	add_sample_mult(pmu, gt_id, sample, val, period_ns / 1000);
+}
+
+/*
+ * Returns true if the actual or requested frequency differs from the previous
+ * invocation, in which case the caller should keep sampling at the base
+ * period.
+ */
+static bool
+frequency_sample(struct intel_gt *gt, unsigned int period_ns, bool backed_off)
 {
 	struct drm_i915_private *i915 = gt->i915;
 	const unsigned int gt_id = gt->info.id;
 	struct i915_pmu *pmu = &i915->pmu;
+	struct i915_pmu_timer *t = &pmu->timer[gt_id];
 	struct intel_rps *rps = &gt->rps;
 	intel_wakeref_t wakeref;
+	bool changed = false;
 
 	if (!frequency_sampling_enabled(pmu, gt_id))
-		return;
+		return false;
 
 	/* Report 0/0 (actual/requested) frequency while parked. */
 	wakeref = intel_gt_pm_get_if_awake(gt);
 	if (!wakeref)
-		return;
+		return false;
 
 	if (pmu->enable & config_mask(__I915_PMU_ACTUAL_FREQUENCY(gt_id))) {
 		u32 val;
@@ -489,34 +646,45 @@ frequency_sample(struct intel_gt *gt, unsigned int period_ns)
 		if (!val)
 			val = intel_gpu_freq(rps, rps->cur_freq);
 
-		add_sample_mult(pmu, gt_id, __I915_SAMPLE_FREQ_ACT,
-				val, period_ns / 1000);
+		add_freq_sample(pmu, gt_id, __I915_SAMPLE_FREQ_ACT,
+				t->freq_act, val, period_ns, backed_off);
+
+		changed |= val != t->freq_act;
+		t->freq_act = val;
 	}
 
-	if (pmu->enable & config_mask(__I915_PMU_REQUESTED_FREQUENCY(gt_id))) {
-		add_sample_mult(pmu, gt_id, __I915_SAMPLE_FREQ_REQ,
-				intel_rps_get_requested_frequency(rps),
-				period_ns / 1000);
+	if (pmu->enable & config_mask(__I915_PMU_REQUESTED_FREQUENCY(gt_id)) &&
+	    requested_frequency_sampled(gt)) {
+		u32 val = intel_rps_get_requested_frequency(rps);
+
+		add_freq_sample(pmu, gt_id, __I915_SAMPLE_FREQ_REQ,
+				t->freq_req, val, period_ns, backed_off);
+
+		changed |= val != t->freq_req;
+		t->freq_req = val;
 	}
 
 	intel_gt_pm_put_async(gt, wakeref);
+
+	return changed;
 }
 
 static enum hrtimer_restart i915_sample(struct hrtimer *hrtimer)
 {
-	struct i915_pmu *pmu = container_of(hrtimer, struct i915_pmu, timer);
-	struct drm_i915_private *i915 = pmu_to_i915(pmu);
+	struct i915_pmu_timer *t = container_of(hrtimer, typeof(*t), timer);
+	struct intel_gt *gt = t->gt;
 	unsigned int period_ns;
-	struct intel_gt *gt;
-	unsigned int i;
+	bool backed_off;
+	bool active;
 	ktime_t now;
 
-	if (!READ_ONCE(pmu->timer_enabled))
+	if (!READ_ONCE(t->enabled))
 		return HRTIMER_NORESTART;
 
 	now = ktime_get();
-	period_ns = ktime_to_ns(ktime_sub(now, pmu->timer_last));
-	pmu->timer_last = now;
+	period_ns = ktime_to_ns(ktime_sub(now, t->last));
+	t->last = now;
+	backed_off = t->period > PERIOD;
 
 	/*
 	 * Strictly speaking the passed in period may not be 100% accurate for
@@ -524,16 +692,20 @@ static enum hrtimer_restart i915_sample(struct hrtimer *hrtimer)
 	 * grabbing the forcewake. However the potential error from timer call-
 	 * back delay greatly dominates this so we keep it simple.
 	 */
+	active = engines_sample(gt, period_ns, backed_off);
+	active |= frequency_sample(gt, period_ns, backed_off);
 
-	for_each_gt(gt, i915, i) {
-		if (!(pmu->unparked & BIT(i)))
-			continue;
-
-		engines_sample(gt, period_ns);
-		frequency_sample(gt, period_ns);
-	}
+	/*
+	 * Back off while the sampled state is stable, since a longer period
+	 * then accumulates exactly the same value, and return to the base
+	 * period as soon as anything changes.
+	 */
+	if (active)
+		t->period = PERIOD;
+	else
+		t->period = min_t(u64, t->period * 2, PERIOD_MAX);
 
-	hrtimer_forward(hrtimer, now, ns_to_ktime(PERIOD));
+	hrtimer_forward(hrtimer, now, ns_to_ktime(t->period));
 
 	return HRTIMER_RESTART;
 }
@@ -693,10 +865,12 @@ static u64 __i915_pmu_event_read(struct perf_event *event)
 				   USEC_PER_SEC /* to MHz */);
 			break;
 		case I915_PMU_REQUESTED_FREQUENCY:
-			val =
-			   div_u64(read_sample(pmu, gt_id,
-					       __I915_SAMPLE_FREQ_REQ),
-				   USEC_PER_SEC /* to MHz */);
+			if (requested_frequency_sampled(i915->gt[gt_id]))
+				val = read_sample(pmu, gt_id,
+						  __I915_SAMPLE_FREQ_REQ);
+			else
+				val = read_rps_req(pmu, i915->gt[gt_id]);
+			val = div_u64(val, USEC_PER_SEC /* to MHz */);
 			break;
 		case I915_PMU_INTERRUPTS:
 			val = READ_ONCE(pmu->irq_count);
@@ -755,11 +929,6 @@ static void i915_pmu_enable(struct perf_event *event)
 	pmu->enable |= BIT(bit);
 	pmu->enable_count[bit]++;
 
-	/*
-	 * Start the sampling timer if needed and not already enabled.
-	 */
-	__i915_pmu_maybe_start_timer(pmu);
-
 	/*
 	 * For per-engine events the bitmask and reference counting
 	 * is stored per engine.
@@ -784,6 +953,11 @@ static void i915_pmu_enable(struct perf_event *event)
 		engine->pmu.enable_count[sample]++;
 	}
 
+	/*
+	 * Start the sampling timers if needed and not already enabled.
+	 */
+	__i915_pmu_update_timers(pmu);
+
 	spin_unlock_irqrestore(&pmu->lock, flags);
 
 update:
@@ -833,10 +1007,10 @@ static void i915_pmu_disable(struct perf_event *event)
 	 * Decrement the reference count and clear the enabled
 	 * bitmask when the last listener on an event goes away.
 	 */
-	if (--pmu->enable_count[bit] == 0) {
+	if (--pmu->enable_count[bit] == 0)
 		pmu->enable &= ~BIT(bit);
-		pmu->timer_enabled &= pmu_needs_timer(pmu);
-	}
+
+	__i915_pmu_update_timers(pmu);
 
 	spin_unlock_irqrestore(&pmu->lock, flags);
 }
@@ -1154,6 +1328,8 @@ void i915_pmu_register(struct drm_i915_private *i915)
 		&pmu->events_attr_group,
 		NULL
 	};
+	struct intel_gt *gt;
+	unsigned int i;
 	int ret = -ENOMEM;
 
 	if (IS_SRIOV_VF(i915)) {
@@ -1162,7 +1338,11 @@ void i915_pmu_register(struct drm_i915_private *i915)
 	}
 
 	spin_lock_init(&pmu->lock);
-	hrtimer_setup(&pmu->timer, i915_sample, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	for (i = 0; i < I915_PMU_MAX_GT; i++)
+		hrtimer_setup(&pmu->timer[i].timer, i915_sample,
+			      CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	for_each_gt(gt, i915, i)
+		pmu->timer[i].gt = gt;
 	init_rc6(pmu);
 
 	if (IS_DGFX(i915)) {
@@ -1221,6 +1401,7 @@ err:
 void i915_pmu_unregister(struct drm_i915_private *i915)
 {
 	struct i915_pmu *pmu = &i915->pmu;
+	unsigned int i;
 
 	if (!pmu->registered)
 		return;
@@ -1228,7 +1409,8 @@ void i915_pmu_unregister(struct drm_i915_private *i915)
 	/* Disconnect the PMU callbacks */
 	pmu->registered = false;
 
-	hrtimer_cancel(&pmu->timer);
+	for (i = 0; i < I915_PMU_MAX_GT; i++)
+		hrtimer_cancel(&pmu->timer[i].timer);
 
 	perf_pmu_unregister(&pmu->base);
 	kfree(pmu->base.attr_groups);
@@ -55,6 +55,52 @@ struct i915_pmu_sample {
 	u64 cur;
 };
 
+/*
+ * Sampling state for a single GT. Each GT runs its own timer so that an idle
+ * or parked GT does not keep waking the CPU on behalf of a busy one.
+ */
+struct i915_pmu_timer {
+	/**
+	 * @timer: Timer for internal i915 PMU sampling of this GT.
+	 */
+	struct hrtimer timer;
+	/**
+	 * @gt: GT sampled by this timer.
+	 */
+	struct intel_gt *gt;
+	/**
+	 * @last: Timestamp of the previous timer invocation.
+	 */
+	ktime_t last;
+	/**
+	 * @period: Current sampling period in ns.
+	 *
+	 * Starts at the base period and backs off while nothing sampled
+	 * changes between invocations.
+	 */
+	u64 period;
+	/**
+	 * @freq_act: Actual frequency seen on the previous invocation.
+	 */
+	u32 freq_act;
+	/**
+	 * @freq_req: Requested frequency seen on the previous invocation.
+	 */
+	u32 freq_req;
+	/**
+	 * @rps_req: Requested frequency last set by host RPS, in MHz.
+	 */
+	u32 rps_req;
+	/**
+	 * @rps_req_last: Time up to which @rps_req has been accounted.
+	 */
+	ktime_t rps_req_last;
+	/**
+	 * @enabled: Should this sampling timer be running.
+	 */
+	bool enabled;
+};
+
 struct i915_pmu {
 	/**
 	 * @base: PMU base.
@@ -77,9 +123,9 @@ struct i915_pmu {
 	 */
 	unsigned int unparked;
 	/**
-	 * @timer: Timer for internal i915 PMU sampling.
+	 * @timer: Per GT timers for internal i915 PMU sampling.
 	 */
-	struct hrtimer timer;
+	struct i915_pmu_timer timer[I915_PMU_MAX_GT];
 	/**
 	 * @enable: Bitmask of specific enabled events.
 	 *
@@ -93,13 +139,6 @@ struct i915_pmu {
 	 */
 	u32 enable;
 
-	/**
-	 * @timer_last:
-	 *
-	 * Timestamp of the previous timer invocation.
-	 */
-	ktime_t timer_last;
-
 	/**
 	 * @enable_count: Reference counts for the enabled events.
 	 *
@@ -108,14 +147,11 @@ struct i915_pmu {
 	 * are using the PMU API.
 	 */
 	unsigned int enable_count[I915_PMU_MASK_BITS];
-	/**
-	 * @timer_enabled: Should the internal sampling timer be running.
-	 */
-	bool timer_enabled;
 	/**
 	 * @sample: Current and previous (raw) counters for sampling events.
 	 *
-	 * These counters are updated from the i915 PMU sampling timer.
+	 * These counters are updated from the per GT i915 PMU sampling
+	 * timers.
 	 *
 	 * Only global counters are held here, while the per-engine ones are in
 	 * struct intel_engine_cs.
@@ -152,11 +188,13 @@ void i915_pmu_register(struct drm_i915_private *i915);
 void i915_pmu_unregister(struct drm_i915_private *i915);
 void i915_pmu_gt_parked(struct intel_gt *gt);
 void i915_pmu_gt_unparked(struct intel_gt *gt);
+void i915_pmu_gt_rps_set(struct intel_gt *gt, u32 freq);
 #else
 static inline void i915_pmu_register(struct drm_i915_private *i915) {}
 static inline void i915_pmu_unregister(struct drm_i915_private *i915) {}
 static inline void i915_pmu_gt_parked(struct intel_gt *gt) {}
 static inline void i915_pmu_gt_unparked(struct intel_gt *gt) {}
+static inline void i915_pmu_gt_rps_set(struct intel_gt *gt, u32 freq) {}
 #endif
 
 #endif
@@ -25,6 +25,7 @@
 #include <linux/dma-fence-array.h>
 #include <linux/dma-fence-chain.h>
 #include <linux/irq_work.h>
+#include <linux/percpu.h>
 #include <linux/prefetch.h>
 #include <linux/sched.h>
 #include <linux/sched/clock.h>
@@ -40,6 +41,7 @@
 #include "gt/intel_engine_heartbeat.h"
 #include "gt/intel_engine_regs.h"
 #include "gt/intel_gpu_commands.h"
+#include "gt/intel_gt_requests.h"
 #include "gt/intel_reset.h"
 #include "gt/intel_ring.h"
 #include "gt/intel_rps.h"
@@ -97,6 +99,124 @@ static bool i915_fence_enable_signaling(struct dma_fence *fence)
 	return i915_request_enable_breadcrumb(to_request(fence));
 }
 
+/*
+ * A dma_fence deadline (e.g. the next vblank for a flip) is near once the
+ * slack left is no more than we expect the request to take, at which point
+ * we raise it to display priority. Under GuC submission that lifts the
+ * owning context into the highest GuC priority band, which then drops back
+ * shortly after the boosted request leaves the context upon completion.
+ *
+ * Each request has a single deadline timer, which holds a reference to the
+ * request while armed. A closer deadline re-arms it in place, and it is
+ * cancelled as the request is retired.
+ */
+#define RQ_DEADLINE_SLACK_NS (2 * NSEC_PER_MSEC)
+
+static enum hrtimer_restart __rq_deadline_expired(struct hrtimer *hrtimer)
+{
+	struct i915_request *rq =
+		container_of(hrtimer, struct i915_request, deadline.timer);
+	struct intel_gt *gt = rq->engine->gt;
+
+	/* Only ever boost, and so queue, each request once */
+	if (!i915_request_completed(rq) &&
+	    !test_and_set_bit(I915_FENCE_FLAG_DEADLINE, &rq->fence.flags)) {
+		if (llist_add(&rq->deadline.link, &gt->deadline.list))
+			queue_work(system_highpri_wq, &gt->deadline.work);
+	} else {
+		i915_request_put(rq);
+	}
+
+	return HRTIMER_NORESTART;
+}
+
+static void __rq_init_deadline(struct i915_request *rq)
+{
+	struct i915_request_deadline *dl = &rq->deadline;
+
+	dl->time = 0;
+	hrtimer_setup(&dl->timer, __rq_deadline_expired,
+		      CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+}
+
+static void __rq_cancel_deadline(struct i915_request *rq)
+{
+	struct i915_request_deadline *dl = &rq->deadline;
+
+	if (hrtimer_try_to_cancel(&dl->timer) > 0)
+		i915_request_put(rq);
+}
+
+static void i915_fence_set_deadline(struct dma_fence *fence, ktime_t deadline)
+{
+	struct i915_request *rq = to_request(fence);
+	struct i915_request_deadline *dl = &rq->deadline;
+	ktime_t old = READ_ONCE(dl->time);
+	unsigned long flags;
+	s64 lead;
+
+	/* Only the earliest deadline matters */
+	do {
+		if (old && ktime_before(old, deadline))
+			return;
+	} while (!try_cmpxchg64(&dl->time, &old, deadline));
+
+	lead = ewma_rq_duration_read(&rq->context->stats.rq_duration) +
+		RQ_DEADLINE_SLACK_NS;
+	deadline = ktime_sub_ns(deadline, lead);
+
+	/*
+	 * Serialised against signaling, and so retirement, by rq->lock: once
+	 * the fence is signaled, i915_request_retire() is left to cancel any
+	 * timer we have armed, and we must not arm another.
+	 */
+	spin_lock_irqsave(&rq->lock, flags);
+	if (!test_bit(I915_FENCE_FLAG_DEADLINE, &rq->fence.flags) &&
+	    !test_bit(DMA_FENCE_FLAG_SIGNALED_BIT, &rq->fence.flags)) {
+		/* Reuse the reference of a pending timer, else take one */
+		if (hrtimer_try_to_cancel(&dl->timer) <= 0)
+			i915_request_get(rq);
+		hrtimer_start(&dl->timer, deadline, HRTIMER_MODE_ABS);
+	}
+	spin_unlock_irqrestore(&rq->lock, flags);
+}
+
+static void __rq_record_latency(struct i915_request *rq)
+{
+	struct intel_engine_cs *engine = rq->engine;
+
+	if (!rq->added || !rq->submitted)
+		return;
+
+	intel_engine_record_latency(engine, INTEL_ENGINE_LATENCY_QUEUE,
+				    ktime_sub(rq->submitted, rq->added));
+
+	/* Not every request is seen switching in, so this is sampled */
+	if (!rq->context_in ||
+	    !test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &rq->fence.flags))
+		return;
+
+	intel_engine_record_latency(engine, INTEL_ENGINE_LATENCY_SCHEDULE,
+				    ktime_sub(rq->context_in, rq->submitted));
+	intel_engine_record_latency(engine, INTEL_ENGINE_LATENCY_RUN,
+				    ktime_sub(rq->fence.timestamp,
+					      rq->context_in));
+}
+
+static void __rq_record_deadline(struct i915_request *rq)
+{
+	struct intel_engine_cs *engine = rq->engine;
+
+	if (!rq->deadline.time ||
+	    !test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &rq->fence.flags))
+		return;
+
+	if (ktime_after(rq->fence.timestamp, rq->deadline.time))
+		atomic_long_inc(&engine->stats.deadline.miss);
+	else
+		atomic_long_inc(&engine->stats.deadline.met);
+}
+
 static signed long i915_fence_wait(struct dma_fence *fence,
 				   bool interruptible,
 				   signed long timeout)
@@ -111,6 +231,110 @@ struct kmem_cache *i915_request_slab_cache(void)
 	return slab_requests;
 }
 
+/*
+ * Each CPU keeps a small magazine of released requests to hand out to the
+ * next allocation before we go back to the slab. As the requests in the
+ * magazine have already dropped their last reference, and are reused only
+ * by __i915_request_create() exactly as if they came from the slab
+ * freelist, they remain compatible with the SLAB_TYPESAFE_BY_RCU lookups.
+ *
+ * The magazines are shared by all devices, like the slab itself, and are
+ * drained back to the slab when a GT parks or under memory pressure.
+ */
+#define RQ_MAGAZINE_SIZE 16
+
+struct i915_request_magazine {
+	spinlock_t lock;
+	unsigned int count;
+	struct i915_request *rq[RQ_MAGAZINE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct i915_request_magazine, rq_magazines);
+
+static struct i915_request *rq_magazine_get(void)
+{
+	struct i915_request_magazine *mag;
+	struct i915_request *rq = NULL;
+	unsigned long flags;
+
+	/*
+	 * We do not pin ourselves to the cpu, if we are migrated we may
+	 * end up using a remote magazine, which is merely suboptimal.
+	 */
+	mag = raw_cpu_ptr(&rq_magazines);
+	if (!READ_ONCE(mag->count))
+		return NULL;
+
+	spin_lock_irqsave(&mag->lock, flags);
+	if (mag->count)
+		rq = mag->rq[--mag->count];
+	spin_unlock_irqrestore(&mag->lock, flags);
+
+	return rq;
+}
+
+static bool rq_magazine_put(struct i915_request *rq)
+{
+	struct i915_request_magazine *mag;
+	unsigned long flags;
+	bool ret = false;
+
+	mag = raw_cpu_ptr(&rq_magazines);
+	if (READ_ONCE(mag->count) == RQ_MAGAZINE_SIZE)
+		return false;
+
+	spin_lock_irqsave(&mag->lock, flags);
+	if (mag->count < RQ_MAGAZINE_SIZE) {
+		mag->rq[mag->count++] = rq;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&mag->lock, flags);
+
+	return ret;
+}
+
+/**
+ * i915_request_magazines_drain - return the cached requests to the slab
+ *
+ * Empties the per-cpu magazines of released requests so that their
+ * memory can be reclaimed by the slab.
+ */
+void i915_request_magazines_drain(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct i915_request_magazine *mag = per_cpu_ptr(&rq_magazines, cpu);
+		struct i915_request *stash[RQ_MAGAZINE_SIZE];
+		unsigned long flags;
+		unsigned int count;
+
+		if (!READ_ONCE(mag->count))
+			continue;
+
+		spin_lock_irqsave(&mag->lock, flags);
+		count = mag->count;
+		memcpy(stash, mag->rq, count * sizeof(*stash));
+		mag->count = 0;
+		spin_unlock_irqrestore(&mag->lock, flags);
+
+		while (count--)
+			kmem_cache_free(slab_requests, stash[count]);
+	}
+}
+
+static struct i915_request *request_alloc(gfp_t gfp)
+{
+	struct i915_request *rq;
+
+	rq = rq_magazine_get();
+	if (rq)
+		return rq;
+
+	return kmem_cache_alloc(slab_requests,
+				gfp | __GFP_RETRY_MAYFAIL | __GFP_NOWARN);
+}
+
 static void i915_fence_release(struct dma_fence *fence)
 {
 	struct i915_request *rq = to_request(fence);
@@ -169,6 +393,10 @@ static void i915_fence_release(struct dma_fence *fence)
 	    !cmpxchg(&rq->engine->request_pool, NULL, rq))
 		return;
 
+	/* Otherwise, recycle the request through this cpu's magazine */
+	if (rq_magazine_put(rq))
+		return;
+
 	kmem_cache_free(slab_requests, rq);
 }
 
@@ -179,6 +407,7 @@ const struct dma_fence_ops i915_fence_ops = {
 	.signaled = i915_fence_signaled,
 	.wait = i915_fence_wait,
 	.release = i915_fence_release,
+	.set_deadline = i915_fence_set_deadline,
 };
 
 static void irq_execute_cb(struct irq_work *wrk)
@@ -355,6 +584,29 @@ void i915_request_free_capture_list(struct i915_capture_list *capture)
 
 #endif
 
+/*
+ * Anything longer than this is far beyond any sensible busywait, and
+ * clamping keeps the ewma within range of an unsigned long on 32b.
+ */
+#define RQ_DURATION_MAX_NS (100 * NSEC_PER_MSEC)
+
+static void __rq_update_duration(struct i915_request *rq)
+{
+	s64 dt;
+
+	/* Skipped or cancelled requests tell us nothing about the workload */
+	if (!rq->submitted || rq->fence.error ||
+	    !test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &rq->fence.flags))
+		return;
+
+	dt = ktime_to_ns(ktime_sub(rq->fence.timestamp, rq->submitted));
+	if (dt <= 0)
+		return;
+
+	ewma_rq_duration_add(&rq->context->stats.rq_duration,
+			     min_t(s64, dt, RQ_DURATION_MAX_NS));
+}
+
 bool i915_request_retire(struct i915_request *rq)
 {
 	if (!__i915_request_is_complete(rq))
@@ -390,9 +642,20 @@ bool i915_request_retire(struct i915_request *rq)
 		spin_unlock_irq(&rq->lock);
 	}
 
+	/* After signaling, so that no new deadline timer can be armed */
+	__rq_cancel_deadline(rq);
+
 	if (test_and_set_bit(I915_FENCE_FLAG_BOOST, &rq->fence.flags))
 		intel_rps_dec_waiters(&rq->engine->gt->rps);
 
+	/* Serialised with other retirements by the timeline mutex */
+	__rq_update_duration(rq);
+	__rq_record_deadline(rq);
+	__rq_record_latency(rq);
+	if (test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &rq->fence.flags))
+		intel_gt_record_retire_latency(rq->engine->gt,
+					       rq->fence.timestamp);
+
 	/*
 	 * We only loosely track inflight requests across preemption,
 	 * and so we may find ourselves attempting to retire a _completed_
@@ -669,6 +932,8 @@ bool __i915_request_submit(struct i915_request *request)
 				     request->ring->vaddr + request->postfix);
 
 	trace_i915_request_execute(request);
+	if (!request->submitted)
+		WRITE_ONCE(request->submitted, ktime_get());
 	if (engine->bump_serial)
 		engine->bump_serial(engine);
 	else
@@ -949,10 +1214,11 @@ __i915_request_create(struct intel_context *ce, gfp_t gfp)
 	 * then we grab a reference and double check that it is still the
 	 * active request - which it won't be and restart the lookup.
 	 *
-	 * Do not use kmem_cache_zalloc() here!
+	 * Do not use kmem_cache_zalloc() here! The same applies to requests
+	 * recycled through the per-cpu magazines, which are handed back to
+	 * us without being cleared.
 	 */
-	rq = kmem_cache_alloc(slab_requests,
-			      gfp | __GFP_RETRY_MAYFAIL | __GFP_NOWARN);
+	rq = request_alloc(gfp);
 	if (unlikely(!rq)) {
 		rq = request_alloc_slow(tl, &ce->engine->request_pool, gfp);
 		if (!rq) {
@@ -965,6 +1231,9 @@ __i915_request_create(struct intel_context *ce, gfp_t gfp)
 	rq->engine = ce->engine;
 	rq->ring = ce->ring;
 	rq->execution_mask = ce->engine->mask;
+	rq->submitted = 0;
+	rq->added = 0;
+	rq->context_in = 0;
 	rq->i915 = ce->engine->i915;
 
 	ret = intel_timeline_get_seqno(tl, rq, &seqno);
@@ -991,6 +1260,7 @@ __i915_request_create(struct intel_context *ce, gfp_t gfp)
 	/* No zalloc, everything must be cleared after use */
 	clear_batch_ptr(rq);
 	__rq_init_watchdog(rq);
+	__rq_init_deadline(rq);
 	assert_capture_list_is_null(rq);
 	GEM_BUG_ON(!llist_empty(&rq->execute_cb));
 	GEM_BUG_ON(rq->batch_res);
@@ -1876,6 +2146,7 @@ void i915_request_add(struct i915_request *rq)
 	lockdep_unpin_lock(&tl->mutex, rq->cookie);
 
 	trace_i915_request_add(rq);
+	rq->added = ktime_get();
 	__i915_request_commit(rq);
 
 	/* XXX placeholder for selftests */
@@ -1923,25 +2194,62 @@ static bool busywait_stop(unsigned long timeout, unsigned int cpu)
 	return this_cpu != cpu;
 }
 
+static unsigned long spin_timeout_ns(const struct i915_request *rq)
+{
+	unsigned long max = READ_ONCE(rq->engine->props.max_busywait_duration_ns);
+	unsigned long avg = ewma_rq_duration_read(&rq->context->stats.rq_duration);
+	ktime_t submitted = READ_ONCE(rq->submitted);
+	s64 remaining;
+
+	/* Without any history, fallback to the fixed busywait */
+	if (!avg || !submitted)
+		return max;
+
+	remaining = avg - ktime_to_ns(ktime_sub(ktime_get(), submitted));
+
+	/*
+	 * If the request is overdue, it may be about to complete at any
+	 * moment, so give it the full busywait. If it is predicted to
+	 * complete within the busywait, only spin for a little past the
+	 * expected completion. And if it is predicted to run for longer
+	 * than the busywait, spinning is just a waste of CPU.
+	 */
+	if (remaining <= 0)
+		return max;
+	if (remaining > max)
+		return 0;
+
+	return min_t(u64, max, remaining + (max >> 2));
+}
+
 static bool __i915_spin_request(struct i915_request * const rq, int state)
 {
+	struct intel_engine_cs *engine = rq->engine;
 	unsigned long timeout_ns;
 	unsigned int cpu;
 
 	/*
 	 * Only wait for the request if we know it is likely to complete.
 	 *
-	 * We don't track the timestamps around requests, nor the average
-	 * request length, so we do not have a good indicator that this
-	 * request will complete within the timeout. What we do know is the
-	 * order in which requests are executed by the context and so we can
-	 * tell if the request has been started. If the request is not even
-	 * running yet, it is a fair assumption that it will not complete
-	 * within our relatively short timeout.
+	 * We know the order in which requests are executed by the context
+	 * and so we can tell if the request has been started. If the request
+	 * is not even running yet, it is a fair assumption that it will not
+	 * complete within our relatively short timeout.
 	 */
 	if (!i915_request_is_running(rq))
 		return false;
 
+	/*
+	 * Once running, we use the recent average duration of requests on
+	 * this context to predict whether it will complete within the
+	 * timeout, and if so, for how long it is worth spinning.
+	 */
+	timeout_ns = spin_timeout_ns(rq);
+	if (!timeout_ns) {
+		atomic_long_inc(&engine->stats.busywait.skip);
+		return false;
+	}
+
 	/*
 	 * When waiting for high frequency requests, e.g. during synchronous
 	 * rendering split between the CPU and GPU, the finite amount of time
@@ -1953,11 +2261,12 @@ static bool __i915_spin_request(struct i915_request * const rq, int state)
 	 * takes to sleep on a request, on the order of a microsecond.
 	 */
 
-	timeout_ns = READ_ONCE(rq->engine->props.max_busywait_duration_ns);
 	timeout_ns += local_clock_ns(&cpu);
 	do {
-		if (dma_fence_is_signaled(&rq->fence))
+		if (dma_fence_is_signaled(&rq->fence)) {
+			atomic_long_inc(&engine->stats.busywait.hit);
 			return true;
+		}
 
 		if (signal_pending_state(state, current))
 			break;
@@ -1968,6 +2277,7 @@ static bool __i915_spin_request(struct i915_request * const rq, int state)
 		cpu_relax();
 	} while (!need_resched());
 
+	atomic_long_inc(&engine->stats.busywait.miss);
 	return false;
 }
 
@@ -2050,7 +2360,8 @@ long i915_request_wait_timeout(struct i915_request *rq,
 	 * polling". The suggestion there is to sleep until just before you
 	 * expect to be woken by the device interrupt and then poll for its
 	 * completion. That requires having a good predictor for the request
-	 * duration, which we currently lack.
+	 * duration; we only use the average duration of recent requests on
+	 * the context to decide whether and for how long to spin.
 	 */
 	if (CONFIG_DRM_I915_MAX_REQUEST_BUSYWAIT &&
 	    __i915_spin_request(rq, state))
@@ -2307,12 +2618,18 @@ enum i915_request_state i915_test_request_state(struct i915_request *rq)
 
 void i915_request_module_exit(void)
 {
+	i915_request_magazines_drain();
 	kmem_cache_destroy(slab_execute_cbs);
 	kmem_cache_destroy(slab_requests);
 }
 
 int __init i915_request_module_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(&rq_magazines, cpu)->lock);
+
 	slab_requests =
 		kmem_cache_create("i915_request",
 				  sizeof(struct i915_request),
@@ -192,6 +192,12 @@ enum {
 
 	I915_FENCE_FLAG_UFENCE,
 
+	/*
+	 * I915_FENCE_FLAG_DEADLINE - this request has been raised to display
+	 * priority as its dma_fence deadline approached
+	 */
+	I915_FENCE_FLAG_DEADLINE,
+
 	__I915_FENCE_FLAG_LAST__
 
 };
@@ -294,6 +300,31 @@ struct i915_request {
 	struct i915_dependency dep;
 	intel_engine_mask_t execution_mask;
 
+	/*
+	 * CPU timestamp of the first submission to HW, used to measure
+	 * the request duration for the busywait predictor.
+	 */
+	ktime_t submitted;
+
+	/*
+	 * CPU timestamps of i915_request_add(), and of when the backend
+	 * first saw the context switched in for this request, for the
+	 * per-engine submission latency histograms.
+	 */
+	ktime_t added;
+	ktime_t context_in;
+
+	/* dma_fence deadline support fields. */
+	struct i915_request_deadline {
+		struct llist_node link;
+		struct hrtimer timer;
+		/*
+		 * Earliest deadline hinted by dma_fence_set_deadline(), or 0
+		 * if nobody is waiting on this request against a deadline.
+		 */
+		ktime_t time;
+	} deadline;
+
 	/*
 	 * A convenience pointer to the current breadcrumb value stored in
 	 * the HW status page (or our timeline's local equivalent). The full
@@ -396,6 +427,7 @@ static inline bool dma_fence_is_i915(const struct dma_fence *fence)
 }
 
 struct kmem_cache *i915_request_slab_cache(void);
+void i915_request_magazines_drain(void);
 
 struct i915_request * __must_check
 __i915_request_create(struct intel_context *ce, gfp_t gfp);
@@ -544,6 +576,16 @@ static inline bool __i915_request_has_started(const struct i915_request *rq)
 	return i915_seqno_passed(__hwsp_seqno(rq), rq->fence.seqno - 1);
 }
 
+/*
+ * Record the first time the backend observes the request running on the
+ * HW, be that from a CS event or from the HWSP.
+ */
+static inline void i915_request_mark_context_in(struct i915_request *rq)
+{
+	if (!READ_ONCE(rq->context_in))
+		WRITE_ONCE(rq->context_in, ktime_get());
+}
+
 /**
  * i915_request_started - check if the request has begun being executed
  * @rq: the request
@@ -9,6 +9,7 @@
 
 #include <linux/pfn.h>
 #include <linux/scatterlist.h>
+#include <linux/sizes.h>
 #include <linux/dma-mapping.h>
 #include <xen/xen.h>
 
@@ -160,6 +161,45 @@ static inline unsigned int i915_sg_segment_size(struct device *dev)
 	return round_down(max, PAGE_SIZE);
 }
 
+/**
+ * i915_sg_segment_align - Align a maximum segment size to a GTT page size
+ * @max_segment: The maximum segment size, as from i915_sg_segment_size()
+ *
+ * Splitting a physically contiguous run at an arbitrary segment limit leaves
+ * the following segment misaligned for 64K/2M GTT entries, even though the
+ * backing large folios were suitably aligned. Round the limit down so that
+ * segments only ever break on a huge page boundary.
+ *
+ * Return: The aligned maximum segment size.
+ */
+static inline unsigned int i915_sg_segment_align(unsigned int max_segment)
+{
+	if (max_segment >= SZ_2M)
+		return round_down(max_segment, SZ_2M);
+	if (max_segment >= SZ_64K)
+		return round_down(max_segment, SZ_64K);
+	return max_segment;
+}
+
+/**
+ * i915_sg_segment_fallback - Pick a smaller segment size after a DMA failure
+ * @max_segment: The maximum segment size that failed to map
+ *
+ * If DMA remapping could not reserve enough large entries, retry with the
+ * next GTT page size down rather than dropping straight to PAGE_SIZE, so
+ * that the object may still be bound using huge PTEs.
+ *
+ * Return: The next maximum segment size to try.
+ */
+static inline unsigned int i915_sg_segment_fallback(unsigned int max_segment)
+{
+	if (max_segment > SZ_2M)
+		return SZ_2M;
+	if (max_segment > SZ_64K)
+		return SZ_64K;
+	return PAGE_SIZE;
+}
+
 bool i915_sg_trim(struct sg_table *orig_st);
 
 /**
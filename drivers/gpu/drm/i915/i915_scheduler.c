@@ -4,6 +4,7 @@
  * Copyright © 2018 Intel Corporation
  */
 
+#include <linux/hash.h>
 #include <linux/mutex.h>
 
 #include "i915_drv.h"
@@ -13,7 +14,47 @@
 static struct kmem_cache *slab_dependencies;
 static struct kmem_cache *slab_priorities;
 
-static DEFINE_SPINLOCK(schedule_lock);
+/*
+ * The dependency lists of each node are guarded by one of a small table of
+ * hashed locks, so that adding and removing dependencies only serialises
+ * against the handful of nodes actually involved. The priority walk only
+ * takes the lock of the node whose signalers it is currently reading.
+ */
+#define SCHED_LOCK_BITS 6
+
+static struct {
+	spinlock_t lock;
+} ____cacheline_aligned_in_smp sched_locks[BIT(SCHED_LOCK_BITS)];
+
+static DEFINE_PER_CPU(unsigned long, sched_dfs_seq);
+
+static spinlock_t *node_lock(const struct i915_sched_node *node)
+{
+	return &sched_locks[hash_ptr(node, SCHED_LOCK_BITS)].lock;
+}
+
+static void lock_nodes(const struct i915_sched_node *a,
+		       const struct i915_sched_node *b)
+{
+	spinlock_t *la = node_lock(a), *lb = node_lock(b);
+
+	if (la > lb)
+		swap(la, lb);
+
+	spin_lock(la);
+	if (lb != la)
+		spin_lock_nested(lb, SINGLE_DEPTH_NESTING);
+}
+
+static void unlock_nodes(const struct i915_sched_node *a,
+			 const struct i915_sched_node *b)
+{
+	spinlock_t *la = node_lock(a), *lb = node_lock(b);
+
+	if (lb != la)
+		spin_unlock(lb);
+	spin_unlock(la);
+}
 
 static const struct i915_request *
 node_to_request(const struct i915_sched_node *node)
@@ -152,26 +193,174 @@ lock_sched_engine(struct i915_sched_node *node,
 	return locked;
 }
 
-static void __i915_schedule(struct i915_sched_node *node,
-			    const struct i915_sched_attr *attr)
+/*
+ * The walk keeps its own stack of the nodes being visited, and the list of
+ * nodes in the order they must be bumped (signalers before waiters), rather
+ * than threading a list through the shared dependencies. Small walks use
+ * the inline storage; larger walks spill into an atomic allocation and, if
+ * that fails, are truncated as a priority bump is only ever a hint.
+ *
+ * Every node on the stack or in the order list holds a reference to its
+ * request, so that it cannot be retired and recycled from under the walk.
+ * The position within each node's signalers is kept as an index, rather
+ * than as a pointer into a list that may be modified as soon as we drop
+ * the node lock. The index is only meaningful for the generation of the
+ * list it was taken from; should a dependency be added or removed in the
+ * meantime, we restart from the head of the list rather than risk
+ * skipping over a signaler. Those already visited are then skipped by
+ * their cookie or raised priority.
+ */
+#define SCHED_WALK_INLINE 8
+
+struct sched_walk {
+	struct sched_frame {
+		struct i915_sched_node *node;
+		unsigned int pos;
+		unsigned int gen;
+	} *stack, inline_stack[SCHED_WALK_INLINE];
+	struct i915_sched_node **order, *inline_order[SCHED_WALK_INLINE];
+	unsigned int depth, count, size;
+	unsigned long cookie;
+};
+
+static void sched_walk_init(struct sched_walk *walk)
 {
-	const int prio = max(attr->priority, node->attr.priority);
-	struct i915_sched_engine *sched_engine;
-	struct i915_dependency *dep, *p;
-	struct i915_dependency stack;
-	struct sched_cache cache;
-	LIST_HEAD(dfs);
+	int cpu;
 
-	/* Needed in order to use the temporary link inside i915_dependency */
-	lockdep_assert_held(&schedule_lock);
-	GEM_BUG_ON(prio == I915_PRIORITY_INVALID);
+	walk->stack = walk->inline_stack;
+	walk->order = walk->inline_order;
+	walk->depth = 0;
+	walk->count = 0;
+	walk->size = SCHED_WALK_INLINE;
 
-	if (node_signaled(node))
-		return;
+	/*
+	 * A cookie unique to this walk, without sharing a counter between
+	 * cpus. As the sequence starts from 1, 0 is never handed out and
+	 * remains reserved for unvisited nodes.
+	 */
+	cpu = get_cpu();
+	walk->cookie = ++per_cpu(sched_dfs_seq, cpu) * nr_cpu_ids + cpu;
+	put_cpu();
+}
+
+static void sched_walk_release(struct sched_walk *walk)
+{
+	unsigned int i;
 
-	stack.signaler = node;
-	list_add(&stack.dfs_link, &dfs);
+	for (i = 0; i < walk->count; i++)
+		i915_request_put(container_of(walk->order[i],
+					      struct i915_request, sched));
+}
+
+static void sched_walk_fini(struct sched_walk *walk)
+{
+	if (walk->stack != walk->inline_stack)
+		kfree(walk->stack);
+	if (walk->order != walk->inline_order)
+		kfree(walk->order);
+}
+
+static bool sched_walk_grow(struct sched_walk *walk)
+{
+	const unsigned int size = 2 * walk->size;
+	struct i915_sched_node **order;
+	struct sched_frame *stack;
+
+	stack = kmalloc_array(size, sizeof(*stack), GFP_ATOMIC | __GFP_NOWARN);
+	order = kmalloc_array(size, sizeof(*order), GFP_ATOMIC | __GFP_NOWARN);
+	if (!stack || !order) {
+		kfree(stack);
+		kfree(order);
+		return false;
+	}
+
+	memcpy(stack, walk->stack, walk->depth * sizeof(*stack));
+	memcpy(order, walk->order, walk->count * sizeof(*order));
+	sched_walk_fini(walk);
+
+	walk->stack = stack;
+	walk->order = order;
+	walk->size = size;
+	return true;
+}
+
+static bool sched_walk_push(struct sched_walk *walk,
+			    struct i915_sched_node *node)
+{
+	/* Every node on the stack is later moved to the order list */
+	if (walk->depth + walk->count == walk->size && !sched_walk_grow(walk))
+		return false;
+
+	WRITE_ONCE(node->dfs, walk->cookie);
+	walk->stack[walk->depth].node = node;
+	walk->stack[walk->depth].pos = 0;
+	walk->stack[walk->depth].gen = READ_ONCE(node->signalers_gen);
+	walk->depth++;
+	return true;
+}
+
+/*
+ * Find the next signaler of the node at the top of the walk that still needs
+ * its priority raised, and return it with a reference held on its request.
+ *
+ * The dependency cannot be removed from the node's signalers_list without
+ * also holding the node lock, and it is removed before the signaler is
+ * retired, so while we hold the lock the signaler is still the request that
+ * our node waits upon and cannot yet have been recycled.
+ */
+static struct i915_sched_node *
+sched_walk_next(struct sched_walk *walk, struct sched_frame *f, const int prio)
+{
+	struct i915_sched_node *node = f->node;
+	struct i915_sched_node *signal = NULL;
+	struct i915_dependency *dep;
+	unsigned int i = 0;
+
+	spin_lock_irq(node_lock(node));
+	if (f->gen != node->signalers_gen) {
+		f->gen = node->signalers_gen;
+		f->pos = 0;
+	}
+	list_for_each_entry(dep, &node->signalers_list, signal_link) {
+		struct i915_request *rq;
+
+		if (i++ < f->pos)
+			continue;
+		f->pos = i;
+
+		/*
+		 * Within an engine, there can be no cycle, but we may
+		 * refer to the same dependency chain multiple times
+		 * (redundant dependencies are not eliminated) and across
+		 * engines.
+		 */
+		if (READ_ONCE(dep->signaler->dfs) == walk->cookie)
+			continue;
+
+		if (node_signaled(dep->signaler))
+			continue;
+
+		if (prio <= READ_ONCE(dep->signaler->attr.priority))
+			continue;
 
+		rq = i915_request_get_rcu(container_of(dep->signaler,
+						       struct i915_request,
+						       sched));
+		if (!rq)
+			continue;
+
+		signal = &rq->sched;
+		break;
+	}
+	spin_unlock_irq(node_lock(node));
+
+	return signal;
+}
+
+static void sched_walk(struct sched_walk *walk,
+		       struct i915_sched_node *root,
+		       const int prio)
+{
 	/*
 	 * Recursively bump all dependent priorities to match the new request.
 	 *
@@ -182,37 +371,58 @@ static void __i915_schedule(struct i915_sched_node *node,
 	 *	queue_request(node);
 	 * }
 	 * but that may have unlimited recursion depth and so runs a very
-	 * real risk of overunning the kernel stack. Instead, we build
-	 * a flat list of all dependencies starting with the current request.
-	 * As we walk the list of dependencies, we add all of its dependencies
-	 * to the end of the list (this may include an already visited
-	 * request) and continue to walk onwards onto the new dependencies. The
-	 * end result is a topological list of requests in reverse order, the
-	 * last element in the list is the request we must execute first.
+	 * real risk of overunning the kernel stack. Instead, we do the same
+	 * depth-first walk using an explicit stack, and record each node
+	 * once all of its signalers have been recorded. The end result is
+	 * a topological list of requests, the first element in the list is
+	 * the request we must execute first and the last is the root.
+	 *
+	 * Concurrent walks may overwrite our cookie in a node, in which case
+	 * we may record that node more than once; the duplicates are
+	 * harmless as the bump is skipped once the priority is raised.
 	 */
-	list_for_each_entry(dep, &dfs, dfs_link) {
-		struct i915_sched_node *node = dep->signaler;
+	i915_request_get(container_of(root, struct i915_request, sched));
+	sched_walk_push(walk, root);
+	while (walk->depth) {
+		struct sched_frame *f = &walk->stack[walk->depth - 1];
+		struct i915_sched_node *node = f->node;
 
 		/* If we are already flying, we know we have no signalers */
-		if (node_started(node))
+		if (!node_started(node))
+			node = sched_walk_next(walk, f, prio);
+		else
+			node = NULL;
+		if (!node) {
+			walk->order[walk->count++] = f->node;
+			walk->depth--;
 			continue;
+		}
 
-		/*
-		 * Within an engine, there can be no cycle, but we may
-		 * refer to the same dependency chain multiple times
-		 * (redundant dependencies are not eliminated) and across
-		 * engines.
-		 */
-		list_for_each_entry(p, &node->signalers_list, signal_link) {
-			GEM_BUG_ON(p == dep); /* no cycles! */
+		if (!sched_walk_push(walk, node))
+			i915_request_put(container_of(node,
+						      struct i915_request,
+						      sched));
+	}
+}
 
-			if (node_signaled(p->signaler))
-				continue;
+static void __i915_schedule(struct i915_sched_node *node,
+			    const struct i915_sched_attr *attr)
+{
+	const int prio = max(attr->priority, node->attr.priority);
+	struct i915_sched_engine *sched_engine;
+	struct sched_cache cache;
+	struct sched_walk walk;
+	unsigned int count;
+	unsigned int i;
 
-			if (prio > READ_ONCE(p->signaler->attr.priority))
-				list_move_tail(&p->dfs_link, &dfs);
-		}
-	}
+	GEM_BUG_ON(prio == I915_PRIORITY_INVALID);
+
+	if (node_signaled(node))
+		return;
+
+	sched_walk_init(&walk);
+	sched_walk(&walk, node, prio);
+	GEM_BUG_ON(walk.order[walk.count - 1] != node);
 
 	/*
 	 * If we didn't need to bump any existing priorities, and we haven't
@@ -220,29 +430,28 @@ static void __i915_schedule(struct i915_sched_node *node,
 	 * execlists_submit_request()), we can set our own priority and skip
 	 * acquiring the engine locks.
 	 */
-	if (node->attr.priority == I915_PRIORITY_INVALID) {
+	count = walk.count;
+	if (cmpxchg(&node->attr.priority,
+		    I915_PRIORITY_INVALID, attr->priority) ==
+	    I915_PRIORITY_INVALID) {
 		GEM_BUG_ON(!list_empty(&node->link));
-		node->attr = *attr;
-
-		if (stack.dfs_link.next == stack.dfs_link.prev)
-			return;
-
-		__list_del_entry(&stack.dfs_link);
+		count--;
 	}
+	if (!count)
+		goto out;
 
 	memset(&cache, 0, sizeof(cache));
-	sched_engine = node_to_request(node)->engine->sched_engine;
+	local_irq_disable();
+	sched_engine = READ_ONCE(node_to_request(walk.order[0])->engine)->sched_engine;
 	spin_lock(&sched_engine->lock);
 
 	/* Fifo and depth-first replacement ensure our deps execute before us */
-	sched_engine = lock_sched_engine(node, sched_engine, &cache);
-	list_for_each_entry_safe_reverse(dep, p, &dfs, dfs_link) {
-		struct i915_request *from = container_of(dep->signaler,
-							 struct i915_request,
-							 sched);
-		INIT_LIST_HEAD(&dep->dfs_link);
-
-		node = dep->signaler;
+	for (i = 0; i < count; i++) {
+		struct i915_request *from;
+
+		node = walk.order[i];
+		from = container_of(node, struct i915_request, sched);
+
 		sched_engine = lock_sched_engine(node, sched_engine, &cache);
 		lockdep_assert_held(&sched_engine->lock);
 
@@ -284,13 +493,15 @@ static void __i915_schedule(struct i915_sched_node *node,
 	}
 
 	spin_unlock(&sched_engine->lock);
+	local_irq_enable();
+out:
+	sched_walk_release(&walk);
+	sched_walk_fini(&walk);
 }
 
 void i915_schedule(struct i915_request *rq, const struct i915_sched_attr *attr)
 {
-	spin_lock_irq(&schedule_lock);
 	__i915_schedule(&rq->sched, attr);
-	spin_unlock_irq(&schedule_lock);
 }
 
 void i915_sched_node_init(struct i915_sched_node *node)
@@ -307,6 +518,8 @@ void i915_sched_node_reinit(struct i915_sched_node *node)
 	node->attr.priority = I915_PRIORITY_INVALID;
 	node->semaphores = 0;
 	node->flags = 0;
+	node->signalers_gen = 0;
+	node->dfs = 0;
 
 	GEM_BUG_ON(!list_empty(&node->signalers_list));
 	GEM_BUG_ON(!list_empty(&node->waiters_list));
@@ -332,10 +545,10 @@ bool __i915_sched_node_add_dependency(struct i915_sched_node *node,
 {
 	bool ret = false;
 
-	spin_lock_irq(&schedule_lock);
+	local_irq_disable();
+	lock_nodes(node, signal);
 
 	if (!node_signaled(signal)) {
-		INIT_LIST_HEAD(&dep->dfs_link);
 		dep->signaler = signal;
 		dep->waiter = node;
 		dep->flags = flags;
@@ -343,13 +556,15 @@ bool __i915_sched_node_add_dependency(struct i915_sched_node *node,
 		/* All set, now publish. Beware the lockless walkers. */
 		list_add_rcu(&dep->signal_link, &node->signalers_list);
 		list_add_rcu(&dep->wait_link, &signal->waiters_list);
+		node->signalers_gen++;
 
 		/* Propagate the chains */
 		node->flags |= signal->flags;
 		ret = true;
 	}
 
-	spin_unlock_irq(&schedule_lock);
+	unlock_nodes(node, signal);
+	local_irq_enable();
 
 	return ret;
 }
@@ -371,11 +586,57 @@ int i915_sched_node_add_dependency(struct i915_sched_node *node,
 	return 0;
 }
 
+static struct i915_dependency *
+first_dep(struct list_head *list, bool signalers)
+{
+	if (list_empty(list))
+		return NULL;
+
+	if (signalers)
+		return list_first_entry(list, struct i915_dependency, signal_link);
+	else
+		return list_first_entry(list, struct i915_dependency, wait_link);
+}
+
+static struct i915_sched_node *
+other_node(const struct i915_dependency *dep, bool signalers)
+{
+	return signalers ? dep->signaler : dep->waiter;
+}
+
+static struct i915_dependency *
+lock_first_dep(struct i915_sched_node *node,
+	       struct list_head *list, bool signalers)
+{
+	struct i915_sched_node *other;
+	struct i915_dependency *dep;
+
+	/*
+	 * Lock both ends of the first dependency on our list. As the other
+	 * end may be concurrently removing the same dependency, we have to
+	 * confirm it is still first on our list once we hold both locks.
+	 */
+	for (;;) {
+		spin_lock(node_lock(node));
+		dep = first_dep(list, signalers);
+		other = dep ? other_node(dep, signalers) : NULL;
+		spin_unlock(node_lock(node));
+		if (!dep)
+			return NULL;
+
+		lock_nodes(node, other);
+		if (first_dep(list, signalers) == dep &&
+		    other_node(dep, signalers) == other)
+			return dep;
+		unlock_nodes(node, other);
+	}
+}
+
 void i915_sched_node_fini(struct i915_sched_node *node)
 {
-	struct i915_dependency *dep, *tmp;
+	struct i915_dependency *dep;
 
-	spin_lock_irq(&schedule_lock);
+	local_irq_disable();
 
 	/*
 	 * Everyone we depended upon (the fences we wait to be signaled)
@@ -383,27 +644,34 @@ void i915_sched_node_fini(struct i915_sched_node *node)
 	 * However, retirement is run independently on each timeline and
 	 * so we may be called out-of-order.
 	 */
-	list_for_each_entry_safe(dep, tmp, &node->signalers_list, signal_link) {
-		GEM_BUG_ON(!list_empty(&dep->dfs_link));
+	while ((dep = lock_first_dep(node, &node->signalers_list, true))) {
+		struct i915_sched_node *signal = dep->signaler;
 
 		list_del_rcu(&dep->wait_link);
+		list_del_rcu(&dep->signal_link);
+		node->signalers_gen++;
+		unlock_nodes(node, signal);
+
 		if (dep->flags & I915_DEPENDENCY_ALLOC)
 			i915_dependency_free(dep);
 	}
-	INIT_LIST_HEAD(&node->signalers_list);
 
 	/* Remove ourselves from everyone who depends upon us */
-	list_for_each_entry_safe(dep, tmp, &node->waiters_list, wait_link) {
+	while ((dep = lock_first_dep(node, &node->waiters_list, false))) {
+		struct i915_sched_node *waiter = dep->waiter;
+
 		GEM_BUG_ON(dep->signaler != node);
-		GEM_BUG_ON(!list_empty(&dep->dfs_link));
 
 		list_del_rcu(&dep->signal_link);
+		list_del_rcu(&dep->wait_link);
+		waiter->signalers_gen++;
+		unlock_nodes(node, waiter);
+
 		if (dep->flags & I915_DEPENDENCY_ALLOC)
 			i915_dependency_free(dep);
 	}
-	INIT_LIST_HEAD(&node->waiters_list);
 
-	spin_unlock_irq(&schedule_lock);
+	local_irq_enable();
 }
 
 void i915_request_show_with_schedule(struct drm_printer *m,
@@ -493,6 +761,11 @@ void i915_scheduler_module_exit(void)
 
 int __init i915_scheduler_module_init(void)
 {
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sched_locks); i++)
+		spin_lock_init(&sched_locks[i].lock);
+
 	slab_dependencies = KMEM_CACHE(i915_dependency,
 					      SLAB_HWCACHE_ALIGN |
 					      SLAB_TYPESAFE_BY_RCU);
@@ -67,6 +67,8 @@ struct i915_sched_node {
 	unsigned int flags;
 #define I915_SCHED_HAS_EXTERNAL_CHAIN	BIT(0)
 	intel_engine_mask_t semaphores;
+	unsigned int signalers_gen; /* bumped on each signalers_list update */
+	unsigned long dfs; /* cookie of the last priority walk to visit us */
 };
 
 struct i915_dependency {
@@ -74,7 +76,6 @@ struct i915_dependency {
 	struct i915_sched_node *waiter;
 	struct list_head signal_link;
 	struct list_head wait_link;
-	struct list_head dfs_link;
 	unsigned long flags;
 #define I915_DEPENDENCY_ALLOC		BIT(0)
 #define I915_DEPENDENCY_EXTERNAL	BIT(1)
@@ -55,6 +55,33 @@ TRACE_EVENT(i915_gem_shrink,
 		      __entry->dev, __entry->target, __entry->flags)
 );
 
+TRACE_EVENT(i915_gem_shrink_done,
+	    TP_PROTO(struct drm_i915_private *i915, int nid,
+		     unsigned long target, unsigned long scanned,
+		     unsigned long freed),
+	    TP_ARGS(i915, nid, target, scanned, freed),
+
+	    TP_STRUCT__entry(
+			     __field(int, dev)
+			     __field(int, nid)
+			     __field(unsigned long, target)
+			     __field(unsigned long, scanned)
+			     __field(unsigned long, freed)
+			     ),
+
+	    TP_fast_assign(
+			   __entry->dev = i915->drm.primary->index;
+			   __entry->nid = nid;
+			   __entry->target = target;
+			   __entry->scanned = scanned;
+			   __entry->freed = freed;
+			   ),
+
+	    TP_printk("dev=%d, nid=%d, target=%lu, scanned=%lu, freed=%lu",
+		      __entry->dev, __entry->nid, __entry->target,
+		      __entry->scanned, __entry->freed)
+);
+
 TRACE_EVENT(i915_vma_bind,
 	    TP_PROTO(struct i915_vma *vma, unsigned flags),
 	    TP_ARGS(vma, flags),
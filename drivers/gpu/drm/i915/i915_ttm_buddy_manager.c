@@ -3,6 +3,7 @@
  * Copyright © 2021 Intel Corporation
  */
 
+#include <linux/sizes.h>
 #include <linux/slab.h>
 
 #include <drm/drm_buddy.h>
@@ -14,15 +15,42 @@
 
 #include "i915_gem.h"
 
+/*
+ * Small allocations (buffer pools, contexts, page tables, ...) are served
+ * from per size-class caches of pre-split buddy blocks, without taking the
+ * manager lock or walking the buddy free lists. The caches are refilled
+ * and drained in batches under a single hold of the manager lock.
+ */
+#define BUDDY_CACHE_MAX_SIZE	SZ_64K
+#define BUDDY_CACHE_CLASSES	(ilog2(BUDDY_CACHE_MAX_SIZE) - ilog2(SZ_4K) + 1)
+#define BUDDY_CACHE_BATCH	16
+#define BUDDY_CACHE_MAX_BLOCKS	(4 * BUDDY_CACHE_BATCH)
+
+struct i915_ttm_buddy_cache {
+	spinlock_t lock;
+	struct list_head blocks;
+	unsigned int count;
+};
+
 struct i915_ttm_buddy_manager {
 	struct ttm_resource_manager manager;
 	struct drm_buddy mm;
 	struct list_head reserved;
 	struct mutex lock;
 	unsigned long visible_size;
-	unsigned long visible_avail;
+	atomic_long_t visible_avail;
 	unsigned long visible_reserved;
 	u64 default_page_size;
+
+	struct i915_ttm_buddy_cache cache[BUDDY_CACHE_CLASSES];
+	unsigned int cache_classes;
+
+	struct {
+		atomic_long_t hits;
+		atomic_long_t refills;
+		atomic_long_t drains;
+		atomic_long_t lock_contended;
+	} stats;
 };
 
 static struct i915_ttm_buddy_manager *
@@ -31,6 +59,208 @@ to_buddy_manager(struct ttm_resource_manager *man)
 	return container_of(man, struct i915_ttm_buddy_manager, manager);
 }
 
+static void buddy_man_lock(struct i915_ttm_buddy_manager *bman)
+{
+	if (!mutex_trylock(&bman->lock)) {
+		atomic_long_inc(&bman->stats.lock_contended);
+		mutex_lock(&bman->lock);
+	}
+}
+
+static void buddy_man_unlock(struct i915_ttm_buddy_manager *bman)
+{
+	mutex_unlock(&bman->lock);
+}
+
+static int buddy_cache_class(struct i915_ttm_buddy_manager *bman, u64 size)
+{
+	int class;
+
+	if (!is_power_of_2(size) || size < bman->mm.chunk_size)
+		return -1;
+
+	class = ilog2(size) - ilog2(bman->mm.chunk_size);
+	if (class >= bman->cache_classes)
+		return -1;
+
+	return class;
+}
+
+static struct drm_buddy_block *
+buddy_cache_get(struct i915_ttm_buddy_manager *bman, int class)
+{
+	struct i915_ttm_buddy_cache *cache = &bman->cache[class];
+	struct drm_buddy_block *block;
+
+	spin_lock(&cache->lock);
+	block = list_first_entry_or_null(&cache->blocks, typeof(*block), link);
+	if (block) {
+		list_del(&block->link);
+		cache->count--;
+	}
+	spin_unlock(&cache->lock);
+
+	return block;
+}
+
+static void buddy_cache_refill(struct i915_ttm_buddy_manager *bman, int class)
+{
+	struct i915_ttm_buddy_cache *cache = &bman->cache[class];
+	u64 size = bman->mm.chunk_size << class;
+	LIST_HEAD(blocks);
+	unsigned int n;
+
+	buddy_man_lock(bman);
+	for (n = 0; n < BUDDY_CACHE_BATCH; n++) {
+		if (drm_buddy_alloc_blocks(&bman->mm, 0, bman->mm.size,
+					   size, size, &blocks, 0))
+			break;
+	}
+	buddy_man_unlock(bman);
+	if (!n)
+		return;
+
+	atomic_long_inc(&bman->stats.refills);
+
+	spin_lock(&cache->lock);
+	list_splice_tail(&blocks, &cache->blocks);
+	cache->count += n;
+	spin_unlock(&cache->lock);
+}
+
+static bool buddy_cache_put(struct i915_ttm_buddy_manager *bman,
+			    struct list_head *blocks)
+{
+	struct drm_buddy_block *block;
+	struct i915_ttm_buddy_cache *cache;
+	LIST_HEAD(excess);
+	int class;
+
+	if (!list_is_singular(blocks))
+		return false;
+
+	block = list_first_entry(blocks, typeof(*block), link);
+	class = buddy_cache_class(bman, drm_buddy_block_size(&bman->mm, block));
+	if (class < 0)
+		return false;
+
+	cache = &bman->cache[class];
+	spin_lock(&cache->lock);
+	list_move(&block->link, &cache->blocks);
+	if (++cache->count > BUDDY_CACHE_MAX_BLOCKS) {
+		unsigned int n;
+
+		/* Trim the oldest batch back to the buddy allocator */
+		for (n = 0; n < BUDDY_CACHE_BATCH; n++)
+			list_move(cache->blocks.prev, &excess);
+		cache->count -= n;
+	}
+	spin_unlock(&cache->lock);
+
+	if (!list_empty(&excess)) {
+		atomic_long_inc(&bman->stats.drains);
+
+		buddy_man_lock(bman);
+		drm_buddy_free_list(&bman->mm, &excess, 0);
+		buddy_man_unlock(bman);
+	}
+
+	return true;
+}
+
+/* Return all cached blocks to the buddy allocator, under bman->lock */
+static bool buddy_cache_drain(struct i915_ttm_buddy_manager *bman)
+{
+	LIST_HEAD(blocks);
+	unsigned int class;
+
+	lockdep_assert_held(&bman->lock);
+
+	for (class = 0; class < bman->cache_classes; class++) {
+		struct i915_ttm_buddy_cache *cache = &bman->cache[class];
+
+		spin_lock(&cache->lock);
+		list_splice_init(&cache->blocks, &blocks);
+		cache->count = 0;
+		spin_unlock(&cache->lock);
+	}
+
+	if (list_empty(&blocks))
+		return false;
+
+	atomic_long_inc(&bman->stats.drains);
+	drm_buddy_free_list(&bman->mm, &blocks, 0);
+
+	return true;
+}
+
+static u64 buddy_cache_size(struct i915_ttm_buddy_manager *bman)
+{
+	unsigned int class;
+	u64 size = 0;
+
+	for (class = 0; class < bman->cache_classes; class++)
+		size += (u64)READ_ONCE(bman->cache[class].count) *
+			(bman->mm.chunk_size << class);
+
+	return size;
+}
+
+static unsigned long
+buddy_block_visible_pages(struct i915_ttm_buddy_manager *bman,
+			  struct drm_buddy_block *block)
+{
+	unsigned long start = drm_buddy_block_offset(block) >> PAGE_SHIFT;
+	unsigned long end;
+
+	if (start >= bman->visible_size)
+		return 0;
+
+	end = start + (drm_buddy_block_size(&bman->mm, block) >> PAGE_SHIFT);
+	return min(end, bman->visible_size) - start;
+}
+
+static bool buddy_man_alloc_cached(struct i915_ttm_buddy_manager *bman,
+				   struct i915_ttm_buddy_resource *bman_res,
+				   u64 size, u64 min_page_size)
+{
+	struct drm_buddy_block *block;
+	int class;
+
+	/*
+	 * Only unrestricted placements can be served from the cache; a
+	 * single naturally aligned block is also trivially contiguous.
+	 */
+	if (bman_res->flags & ~DRM_BUDDY_CONTIGUOUS_ALLOCATION)
+		return false;
+
+	if (size < min_page_size)
+		return false;
+
+	class = buddy_cache_class(bman, size);
+	if (class < 0)
+		return false;
+
+	block = buddy_cache_get(bman, class);
+	if (!block) {
+		buddy_cache_refill(bman, class);
+		block = buddy_cache_get(bman, class);
+		if (!block)
+			return false;
+	} else {
+		atomic_long_inc(&bman->stats.hits);
+	}
+
+	list_add(&block->link, &bman_res->blocks);
+
+	bman_res->used_visible_size = buddy_block_visible_pages(bman, block);
+	if (bman_res->used_visible_size)
+		atomic_long_sub(bman_res->used_visible_size,
+				&bman->visible_avail);
+
+	return true;
+}
+
 static int i915_ttm_buddy_man_alloc(struct ttm_resource_manager *man,
 				    struct ttm_buffer_object *bo,
 				    const struct ttm_place *place,
@@ -80,54 +310,57 @@ static int i915_ttm_buddy_man_alloc(struct ttm_resource_manager *man,
 		goto err_free_res;
 	}
 
+	if (buddy_man_alloc_cached(bman, bman_res, size, min_page_size)) {
+		*res = &bman_res->base;
+		return 0;
+	}
+
 	n_pages = size >> ilog2(mm->chunk_size);
 
-	mutex_lock(&bman->lock);
-	if (lpfn <= bman->visible_size && n_pages > bman->visible_avail) {
-		mutex_unlock(&bman->lock);
+	buddy_man_lock(bman);
+	if (lpfn <= bman->visible_size &&
+	    n_pages > atomic_long_read(&bman->visible_avail)) {
+		buddy_man_unlock(bman);
 		err = -ENOSPC;
 		goto err_free_res;
 	}
 
+retry:
 	err = drm_buddy_alloc_blocks(mm, (u64)place->fpfn << PAGE_SHIFT,
 				     (u64)lpfn << PAGE_SHIFT,
 				     (u64)n_pages << PAGE_SHIFT,
 				     min_page_size,
 				     &bman_res->blocks,
 				     bman_res->flags);
-	if (unlikely(err))
+	if (unlikely(err)) {
+		/* Reclaim the cached small blocks before giving up */
+		if (err == -ENOSPC && buddy_cache_drain(bman))
+			goto retry;
 		goto err_free_blocks;
+	}
 
 	if (lpfn <= bman->visible_size) {
 		bman_res->used_visible_size = PFN_UP(bman_res->base.size);
 	} else {
 		struct drm_buddy_block *block;
 
-		list_for_each_entry(block, &bman_res->blocks, link) {
-			unsigned long start =
-				drm_buddy_block_offset(block) >> PAGE_SHIFT;
-
-			if (start < bman->visible_size) {
-				unsigned long end = start +
-					(drm_buddy_block_size(mm, block) >> PAGE_SHIFT);
-
-				bman_res->used_visible_size +=
-					min(end, bman->visible_size) - start;
-			}
-		}
+		list_for_each_entry(block, &bman_res->blocks, link)
+			bman_res->used_visible_size +=
+				buddy_block_visible_pages(bman, block);
 	}
 
 	if (bman_res->used_visible_size)
-		bman->visible_avail -= bman_res->used_visible_size;
+		atomic_long_sub(bman_res->used_visible_size,
+				&bman->visible_avail);
 
-	mutex_unlock(&bman->lock);
+	buddy_man_unlock(bman);
 
 	*res = &bman_res->base;
 	return 0;
 
 err_free_blocks:
 	drm_buddy_free_list(mm, &bman_res->blocks, 0);
-	mutex_unlock(&bman->lock);
+	buddy_man_unlock(bman);
 err_free_res:
 	ttm_resource_fini(man, &bman_res->base);
 	kfree(bman_res);
@@ -140,10 +373,12 @@ static void i915_ttm_buddy_man_free(struct ttm_resource_manager *man,
 	struct i915_ttm_buddy_resource *bman_res = to_ttm_buddy_resource(res);
 	struct i915_ttm_buddy_manager *bman = to_buddy_manager(man);
 
-	mutex_lock(&bman->lock);
-	drm_buddy_free_list(&bman->mm, &bman_res->blocks, 0);
-	bman->visible_avail += bman_res->used_visible_size;
-	mutex_unlock(&bman->lock);
+	if (!buddy_cache_put(bman, &bman_res->blocks)) {
+		buddy_man_lock(bman);
+		drm_buddy_free_list(&bman->mm, &bman_res->blocks, 0);
+		buddy_man_unlock(bman);
+	}
+	atomic_long_add(bman_res->used_visible_size, &bman->visible_avail);
 
 	ttm_resource_fini(man, res);
 	kfree(bman_res);
@@ -230,11 +465,18 @@ static void i915_ttm_buddy_man_debug(struct ttm_resource_manager *man,
 	drm_printf(printer, "default_page_size: %lluKiB\n",
 		   bman->default_page_size >> 10);
 	drm_printf(printer, "visible_avail: %lluMiB\n",
-		   (u64)bman->visible_avail << PAGE_SHIFT >> 20);
+		   (u64)atomic_long_read(&bman->visible_avail) << PAGE_SHIFT >> 20);
 	drm_printf(printer, "visible_size: %lluMiB\n",
 		   (u64)bman->visible_size << PAGE_SHIFT >> 20);
 	drm_printf(printer, "visible_reserved: %lluMiB\n",
 		   (u64)bman->visible_reserved << PAGE_SHIFT >> 20);
+	drm_printf(printer, "cached: %lluKiB, hits: %ld, refills: %ld, drains: %ld\n",
+		   buddy_cache_size(bman) >> 10,
+		   atomic_long_read(&bman->stats.hits),
+		   atomic_long_read(&bman->stats.refills),
+		   atomic_long_read(&bman->stats.drains));
+	drm_printf(printer, "lock contended: %ld\n",
+		   atomic_long_read(&bman->stats.lock_contended));
 
 	drm_buddy_print(&bman->mm, printer);
 
@@ -287,6 +529,7 @@ int i915_ttm_buddy_man_init(struct ttm_device *bdev,
 {
 	struct ttm_resource_manager *man;
 	struct i915_ttm_buddy_manager *bman;
+	unsigned int class;
 	int err;
 
 	bman = kzalloc_obj(*bman);
@@ -302,7 +545,16 @@ int i915_ttm_buddy_man_init(struct ttm_device *bdev,
 	GEM_BUG_ON(default_page_size < chunk_size);
 	bman->default_page_size = default_page_size;
 	bman->visible_size = visible_size >> PAGE_SHIFT;
-	bman->visible_avail = bman->visible_size;
+	atomic_long_set(&bman->visible_avail, bman->visible_size);
+
+	if (chunk_size <= BUDDY_CACHE_MAX_SIZE)
+		bman->cache_classes = min_t(unsigned int, BUDDY_CACHE_CLASSES,
+					    ilog2(BUDDY_CACHE_MAX_SIZE) -
+					    ilog2(chunk_size) + 1);
+	for (class = 0; class < bman->cache_classes; class++) {
+		spin_lock_init(&bman->cache[class].lock);
+		INIT_LIST_HEAD(&bman->cache[class].blocks);
+	}
 
 	man = &bman->manager;
 	man->use_tt = use_tt;
@@ -345,10 +597,12 @@ int i915_ttm_buddy_man_fini(struct ttm_device *bdev, unsigned int type)
 	ttm_set_driver_manager(bdev, type, NULL);
 
 	mutex_lock(&bman->lock);
+	buddy_cache_drain(bman);
 	drm_buddy_free_list(mm, &bman->reserved, 0);
 	drm_buddy_fini(mm);
-	bman->visible_avail += bman->visible_reserved;
-	WARN_ON_ONCE(bman->visible_avail != bman->visible_size);
+	atomic_long_add(bman->visible_reserved, &bman->visible_avail);
+	WARN_ON_ONCE(atomic_long_read(&bman->visible_avail) !=
+		     bman->visible_size);
 	mutex_unlock(&bman->lock);
 
 	ttm_resource_manager_cleanup(man);
@@ -379,6 +633,7 @@ int i915_ttm_buddy_man_reserve(struct ttm_resource_manager *man,
 	flags |= DRM_BUDDY_RANGE_ALLOCATION;
 
 	mutex_lock(&bman->lock);
+	buddy_cache_drain(bman);
 	ret = drm_buddy_alloc_blocks(mm, start,
 				     start + size,
 				     size, mm->chunk_size,
@@ -390,7 +645,7 @@ int i915_ttm_buddy_man_reserve(struct ttm_resource_manager *man,
 		unsigned long visible = min(lpfn, bman->visible_size) - fpfn;
 
 		bman->visible_reserved += visible;
-		bman->visible_avail -= visible;
+		atomic_long_sub(visible, &bman->visible_avail);
 	}
 	mutex_unlock(&bman->lock);
 
@@ -424,8 +679,8 @@ void i915_ttm_buddy_man_avail(struct ttm_resource_manager *man,
 	struct i915_ttm_buddy_manager *bman = to_buddy_manager(man);
 
 	mutex_lock(&bman->lock);
-	*avail = bman->mm.avail >> PAGE_SHIFT;
-	*visible_avail = bman->visible_avail;
+	*avail = (bman->mm.avail + buddy_cache_size(bman)) >> PAGE_SHIFT;
+	*visible_avail = atomic_long_read(&bman->visible_avail);
 	mutex_unlock(&bman->lock);
 }
 
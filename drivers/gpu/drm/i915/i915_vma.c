@@ -2038,6 +2038,8 @@ int _i915_vma_move_to_active(struct i915_vma *vma,
 	obj->read_domains |= I915_GEM_GPU_DOMAINS;
 	obj->mm.dirty = true;
 
+	i915_drm_client_object_active(obj);
+
 	GEM_BUG_ON(!i915_vma_is_active(vma));
 	return 0;
 }
@@ -2967,6 +2967,111 @@ out:
 	return ret;
 }
 
+static bool uncore_can_batch(struct intel_uncore *uncore, bool write)
+{
+	/* unclaimed mmio detection has to bracket each individual access */
+	if (unlikely(uncore->i915->params.mmio_debug) && uncore->debug)
+		return false;
+
+	/*
+	 * Only the forcewake table accessors are plain MMIO behind forcewake;
+	 * the others (VF runtime registers, vGPU, gen6 FIFO) need their per
+	 * register handling.
+	 */
+	if (write)
+		return uncore->funcs.mmio_writel == fwtable_write32;
+	else
+		return uncore->funcs.mmio_readl == fwtable_read32;
+}
+
+/**
+ * intel_uncore_read_many - read a set of registers in one batch
+ * @uncore: pointer to struct intel_uncore
+ * @regs: registers to read
+ * @values: returns the register values, in the same order as @regs
+ * @count: number of registers
+ *
+ * Computes the forcewake domains needed by all of @regs up front, wakes them
+ * once and performs all reads under a single hold of the uncore lock, instead
+ * of repeating the lookup and locking for every register as a sequence of
+ * intel_uncore_read() would. Passing @regs sorted by offset keeps accesses to
+ * the same forcewake range together.
+ *
+ * Falls back to individual reads where the platform accessors require per
+ * register handling.
+ */
+void intel_uncore_read_many(struct intel_uncore *uncore,
+			    const i915_reg_t *regs, u32 *values,
+			    unsigned int count)
+{
+	enum forcewake_domains fw_domains = 0;
+	unsigned long irqflags;
+	unsigned int i;
+
+	if (!uncore_can_batch(uncore, false)) {
+		for (i = 0; i < count; i++)
+			values[i] = intel_uncore_read(uncore, regs[i]);
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		fw_domains |= __fwtable_reg_read_fw_domains(uncore,
+							    i915_mmio_reg_offset(regs[i]));
+
+	assert_rpm_wakelock_held(uncore->rpm);
+	spin_lock_irqsave(&uncore->lock, irqflags);
+	if (fw_domains)
+		__force_wake_auto(uncore, fw_domains);
+	for (i = 0; i < count; i++)
+		values[i] = __raw_uncore_read32(uncore, regs[i]);
+	spin_unlock_irqrestore(&uncore->lock, irqflags);
+
+	trace_i915_reg_rw_batch(false, count, fw_domains);
+	for (i = 0; i < count; i++)
+		trace_i915_reg_rw(false, regs[i], values[i], sizeof(u32), true);
+}
+
+/**
+ * intel_uncore_write_many - write a set of registers in one batch
+ * @uncore: pointer to struct intel_uncore
+ * @regs: registers to write
+ * @values: values to write, in the same order as @regs
+ * @count: number of registers
+ *
+ * Like intel_uncore_read_many(), the writes are issued in order under a
+ * single hold of the uncore lock, with the union of the required forcewake
+ * domains taken once.
+ */
+void intel_uncore_write_many(struct intel_uncore *uncore,
+			     const i915_reg_t *regs, const u32 *values,
+			     unsigned int count)
+{
+	enum forcewake_domains fw_domains = 0;
+	unsigned long irqflags;
+	unsigned int i;
+
+	if (!uncore_can_batch(uncore, true)) {
+		for (i = 0; i < count; i++)
+			intel_uncore_write(uncore, regs[i], values[i]);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		trace_i915_reg_rw(true, regs[i], values[i], sizeof(u32), true);
+		fw_domains |= __fwtable_reg_write_fw_domains(uncore,
+							     i915_mmio_reg_offset(regs[i]));
+	}
+	trace_i915_reg_rw_batch(true, count, fw_domains);
+
+	assert_rpm_wakelock_held(uncore->rpm);
+	spin_lock_irqsave(&uncore->lock, irqflags);
+	if (fw_domains)
+		__force_wake_auto(uncore, fw_domains);
+	for (i = 0; i < count; i++)
+		__raw_uncore_write32(uncore, regs[i], values[i]);
+	spin_unlock_irqrestore(&uncore->lock, irqflags);
+}
+
 /**
  * intel_uncore_forcewake_for_reg - which forcewake domains are needed to access
  * 				    a register
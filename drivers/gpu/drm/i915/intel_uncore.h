@@ -274,6 +274,13 @@ void intel_uncore_forcewake_get__locked(struct intel_uncore *uncore,
 void intel_uncore_forcewake_put__locked(struct intel_uncore *uncore,
 					enum forcewake_domains domains);
 
+void intel_uncore_read_many(struct intel_uncore *uncore,
+			    const i915_reg_t *regs, u32 *values,
+			    unsigned int count);
+void intel_uncore_write_many(struct intel_uncore *uncore,
+			     const i915_reg_t *regs, const u32 *values,
+			     unsigned int count);
+
 void intel_uncore_forcewake_user_get(struct intel_uncore *uncore);
 void intel_uncore_forcewake_user_put(struct intel_uncore *uncore);
 
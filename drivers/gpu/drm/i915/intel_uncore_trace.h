@@ -39,6 +39,28 @@ TRACE_EVENT_CONDITION(i915_reg_rw,
 		(u32)(__entry->val & 0xffffffff),
 		(u32)(__entry->val >> 32))
 );
+
+TRACE_EVENT(i915_reg_rw_batch,
+	TP_PROTO(bool write, unsigned int count, u32 fw_domains),
+
+	TP_ARGS(write, count, fw_domains),
+
+	TP_STRUCT__entry(
+		__field(u32, count)
+		__field(u32, fw_domains)
+		__field(u16, write)
+		),
+
+	TP_fast_assign(
+		__entry->count = count;
+		__entry->fw_domains = fw_domains;
+		__entry->write = write;
+		),
+
+	TP_printk("%s count=%u, fw_domains=0x%x",
+		__entry->write ? "write" : "read",
+		__entry->count, __entry->fw_domains)
+);
 #endif /* __INTEL_UNCORE_TRACE_H__ */
 
 /* This part must be outside protection */